@@ -0,0 +1,116 @@
+#pragma once
+#include "../game/game_base.h"
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+namespace Maestro {
+    using namespace std;
+
+    // Runs the batches of evaluate_async() on a pool of inference threads,
+    // so that a search can keep descending while they are scored. Batches
+    // are taken in submission order. The wrapped evaluator must tolerate
+    // concurrent calls when the pool has more than one thread.
+    template<typename TGame>
+    class AsyncEvaluator final : public IEvaluator<TGame> {
+        struct Job {
+            vector<TGame> games;
+            promise<vector<Evaluation<TGame>>> result;
+        };
+
+        shared_ptr<IEvaluator<TGame>> _evaluator;
+        mutex _mutex;
+        condition_variable _cv;
+        deque<Job> _queue;
+        bool _stop = false;
+        vector<thread> _threads;
+        atomic<int64_t> _busy_ns{ 0 };
+
+        void run();
+
+    public:
+        AsyncEvaluator(shared_ptr<IEvaluator<TGame>> evaluator, int n_threads = 1) : _evaluator(std::move(evaluator)) {
+            for (int i = 0; i < max(1, n_threads); i++) {
+                _threads.emplace_back([this]() { run(); });
+            }
+        }
+
+        AsyncEvaluator(const AsyncEvaluator&) = delete;
+        AsyncEvaluator& operator=(const AsyncEvaluator&) = delete;
+
+        // finishes the queued batches first
+        ~AsyncEvaluator() {
+            {
+                lock_guard<mutex> guard(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+            for (auto& t : _threads) {
+                t.join();
+            }
+        }
+
+        Evaluation<TGame> evaluate(const TGame& game) override {
+            return _evaluator->evaluate(game);
+        }
+
+        vector<Evaluation<TGame>> evaluate(const vector<TGame*>& games) override {
+            return _evaluator->evaluate(games);
+        }
+
+        future<vector<Evaluation<TGame>>> evaluate_async(vector<TGame> games) override {
+            Job job;
+            job.games = std::move(games);
+            auto result = job.result.get_future();
+            {
+                lock_guard<mutex> guard(_mutex);
+                _queue.push_back(std::move(job));
+            }
+            _cv.notify_one();
+            return result;
+        }
+
+        double busy_seconds() const override {
+            return _busy_ns.load() / 1e9 / _threads.size();
+        }
+
+        int n_threads() const { return int(_threads.size()); }
+
+        // batches waiting for a thread
+        size_t queue_size() {
+            lock_guard<mutex> guard(_mutex);
+            return _queue.size();
+        }
+    };
+
+    template<typename TGame>
+    inline void AsyncEvaluator<TGame>::run() {
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> lock(_mutex);
+                _cv.wait(lock, [this]() { return _stop || !_queue.empty(); });
+                if (_queue.empty()) return;
+                job = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            auto start = chrono::steady_clock::now();
+            try {
+                vector<TGame*> ptrs;
+                for (auto& g : job.games) {
+                    ptrs.push_back(&g);
+                }
+                job.result.set_value(_evaluator->evaluate(ptrs));
+            }
+            catch (...) {
+                job.result.set_exception(current_exception());
+            }
+            _busy_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "../game/game_base.h"
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+namespace Maestro {
+    using namespace std;
+
+    // Bounded cache of evaluations, meant to be shared by the searches of
+    // one evaluator across moves and games, from any number of threads.
+    // Positions are stored in the orientation given by
+    // Symmetry<TGame>::canonical, so positions equal up to a symmetry share
+    // one entry, and priors are mapped back to the orientation of the query.
+    // Entries are spread over shards by hash, each shard a least recently
+    // used list behind its own lock. Entries are told apart through
+    // EvaluationKey<TGame>, so state such as the last move of a Gomoku,
+    // which the network sees, is part of the cached position.
+    template<typename TGame>
+    class EvaluationCache {
+    public:
+        struct Stat {
+            int64_t lookups = 0, hits = 0, inserts = 0;
+            double hit_rate() const { return lookups > 0 ? double(hits) / lookups : 0; }
+        };
+
+    private:
+        struct Entry {
+            TGame game;
+            Evaluation<TGame> eval;
+        };
+
+        struct Shard {
+            mutex lock;
+            // most recently used first
+            list<Entry> entries;
+            unordered_map<size_t, typename list<Entry>::iterator> index;
+        };
+
+        vector<Shard> _shards;
+        size_t _shard_capacity;
+        atomic<int64_t> _lookups{ 0 }, _hits{ 0 }, _inserts{ 0 };
+
+        Shard& shard(size_t hash) { return _shards[hash % _shards.size()]; }
+
+        static void transform(Evaluation<TGame>& eval, int sym) {
+            if (sym == 0) return;
+            for (auto& mp : eval.p) {
+                mp.move = Symmetry<TGame>::apply(mp.move, sym);
+            }
+        }
+
+    public:
+        explicit EvaluationCache(size_t capacity, int n_shards = 16) :
+            _shards(max(1, n_shards)),
+            _shard_capacity(max<size_t>(1, capacity / max(1, n_shards))) {}
+
+        EvaluationCache(const EvaluationCache&) = delete;
+        EvaluationCache& operator=(const EvaluationCache&) = delete;
+
+        // Copies the cached evaluation of game into out if there is one.
+        bool find(const TGame& game, Evaluation<TGame>& out) {
+            _lookups++;
+            int sym = Symmetry<TGame>::canonical(game);
+            TGame canon = Symmetry<TGame>::apply(game, sym);
+            size_t hash = EvaluationKey<TGame>::hash(canon);
+            Shard& sh = shard(hash);
+            {
+                lock_guard<mutex> guard(sh.lock);
+                auto it = sh.index.find(hash);
+                if (it == sh.index.end() || !EvaluationKey<TGame>::equal(it->second->game, canon)) return false;
+                sh.entries.splice(sh.entries.begin(), sh.entries, it->second);
+                out = it->second->eval;
+            }
+            _hits++;
+            transform(out, Symmetry<TGame>::inverse(sym));
+            return true;
+        }
+
+        // Replaces the least recently used entry of its shard when full.
+        void insert(const TGame& game, const Evaluation<TGame>& eval) {
+            _inserts++;
+            int sym = Symmetry<TGame>::canonical(game);
+            Entry e{ Symmetry<TGame>::apply(game, sym), eval };
+            transform(e.eval, sym);
+            size_t hash = EvaluationKey<TGame>::hash(e.game);
+            Shard& sh = shard(hash);
+            lock_guard<mutex> guard(sh.lock);
+            auto it = sh.index.find(hash);
+            if (it != sh.index.end()) {
+                // the same position, or one colliding with it
+                *it->second = std::move(e);
+                sh.entries.splice(sh.entries.begin(), sh.entries, it->second);
+                return;
+            }
+            if (sh.entries.size() >= _shard_capacity) {
+                sh.index.erase(EvaluationKey<TGame>::hash(sh.entries.back().game));
+                sh.entries.pop_back();
+            }
+            sh.entries.push_front(std::move(e));
+            sh.index[hash] = sh.entries.begin();
+        }
+
+        size_t size() {
+            size_t n = 0;
+            for (auto& sh : _shards) {
+                lock_guard<mutex> guard(sh.lock);
+                n += sh.entries.size();
+            }
+            return n;
+        }
+
+        size_t capacity() const { return _shard_capacity * _shards.size(); }
+
+        Stat stat() const {
+            Stat s;
+            s.lookups = _lookups;
+            s.hits = _hits;
+            s.inserts = _inserts;
+            return s;
+        }
+    };
+}
@@ -1,12 +1,46 @@
 #pragma once
 #include "../game/game_gomoku.h"
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string>
 
 namespace Maestro {
+    // Policy/value network compiled with TVM, run on the CPU by the graph
+    // runtime. A model is one compiled module per supported batch size N:
+    //   <prefix>_b<N>.so, <prefix>_b<N>.json, <prefix>_b<N>.params
+    // taking input "data" of shape [N, PLANES, 15, 15] and producing policy
+    // logits [N, 225] and values [N, 1], both for the player to move. A batch
+    // runs on the smallest module that holds it, padded; larger batches are
+    // split over the largest one.
     class NNGomokuEvaluator final : public IEvaluator<Gomoku> {
     public:
-        Evaluation<Gomoku> evaluate(const Gomoku& game) { 
-            // TODO @wsh
-            return Evaluation<Gomoku>(); 
-        }
+        // stones of the player to move, stones of the opponent, the last
+        // move, and all ones if the player to move is black
+        static const int PLANES = 4;
+        static const int PLANE_SIZE = BOARD_SIZE * BOARD_SIZE;
+
+        NNGomokuEvaluator(const string& model_prefix, vector<int> batch_sizes = { 1, 8, 32, 128, 256 });
+        ~NNGomokuEvaluator();
+
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override;
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override;
+        double busy_seconds() const override { return _busy_ns.load() / 1e9; }
+
+        // batch sizes of the modules found
+        vector<int> batch_sizes() const;
+
+        // writes the input planes of game to out[PLANES * PLANE_SIZE]
+        static void encode(const Gomoku& game, float* out);
+
+    private:
+        struct Runtime;
+        // ascending batch size; each keeps its own preallocated tensors
+        vector<unique_ptr<Runtime>> _runtimes;
+        // a graph runtime runs one batch at a time
+        mutex _mutex;
+        atomic<int64_t> _busy_ns{ 0 };
+
+        void run(Runtime& rt, Gomoku* const* games, int n, Evaluation<Gomoku>* out);
     };
 }
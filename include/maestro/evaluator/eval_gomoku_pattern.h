@@ -0,0 +1,28 @@
+#pragma once
+#include "../game/game_gomoku.h"
+
+namespace Maestro {
+    // Scores the empty cells near the stones by the threats a stone there
+    // would make, for the side to move, or take away, from the other side,
+    // along each of the four lines through it. Threats are looked up in a
+    // table over the 9-cell window centred on the cell. Priors follow the
+    // scores, with wins and forced blocks taken alone, and the value weighs
+    // the threats of both sides from the point of view of the side to move.
+    class PatternGomokuEvaluator final : public IEvaluator<Gomoku> {
+    public:
+        // what a stone on the centre of a window makes, weakest first: an
+        // open four has two ways to five, an open three makes an open four
+        // with one more stone, a three makes a four, and so on
+        enum Threat : uint8_t {
+            NONE, TWO, OPEN_TWO, THREE, OPEN_THREE, FOUR, OPEN_FOUR, FIVE, THREAT_COUNT
+        };
+
+        // The threat of a stone on the centre of a window. Bit i of own and
+        // blocked is cell i of the window, bit 4 being the centre; blocked
+        // cells hold a stone of the other side or are off the board. Cells
+        // past a blocked one are ignored.
+        static Threat threat(uint32_t own, uint32_t blocked);
+
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override;
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "../game/game_gomoku.h"
+#include <memory>
+
+namespace Maestro {
+    // Evaluates every position under n_symmetries distinct symmetries of
+    // the board, drawn per position, in one batch of the wrapped evaluator,
+    // and averages the values and the priors mapped back to the position.
+    // With one symmetry this costs nothing but the transforms; with all
+    // eight the result no longer depends on the orientation. The choice is
+    // a function of the position and the seed, so results are reproducible.
+    // Batches are evaluated synchronously: to pipeline them, wrap this in
+    // an AsyncEvaluator or InferenceServer rather than the other way round.
+    class SymmetricGomokuEvaluator final : public IEvaluator<Gomoku> {
+        shared_ptr<IEvaluator<Gomoku>> _evaluator;
+        int _n_symmetries;
+        uint64_t _seed;
+
+        // writes the n_symmetries symmetries used for game to syms
+        void pick_symmetries(const Gomoku& game, int* syms) const;
+
+    public:
+        SymmetricGomokuEvaluator(shared_ptr<IEvaluator<Gomoku>> evaluator, int n_symmetries = 1, uint64_t seed = 0);
+
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override;
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override;
+        double busy_seconds() const override { return _evaluator->busy_seconds(); }
+
+        int n_symmetries() const { return _n_symmetries; }
+    };
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include "../game/game_base.h"
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+namespace Maestro {
+    using namespace std;
+
+    // Evaluator shared by many concurrent searches, e.g. one per game of a
+    // self-play run. Requests from all of them are merged into batches of up
+    // to max_batch_size positions for the wrapped evaluator. A batch is sent
+    // once it is full or its oldest request has waited max_latency, and each
+    // request gets back the evaluations of its own positions.
+    template<typename TGame>
+    class InferenceServer final : public IEvaluator<TGame> {
+    public:
+        struct Config {
+            int max_batch_size = 256;
+            chrono::microseconds max_latency{ 2000 };
+            // threads running batches, each takes the next batch when free
+            int n_threads = 1;
+        };
+
+        struct Stat {
+            size_t n_requests = 0, n_positions = 0, n_batches = 0;
+            // time from submission to result, summed over requests
+            double latency_seconds = 0;
+            double max_latency_seconds = 0;
+            double busy_seconds = 0;
+            double mean_batch_size() const { return n_batches > 0 ? double(n_positions) / n_batches : 0; }
+            double mean_latency() const { return n_requests > 0 ? latency_seconds / n_requests : 0; }
+        };
+
+    private:
+        using Clock = chrono::steady_clock;
+
+        struct Request {
+            vector<TGame> games;
+            promise<vector<Evaluation<TGame>>> result;
+            Clock::time_point arrival;
+        };
+
+        shared_ptr<IEvaluator<TGame>> _evaluator;
+        Config _config;
+        mutable mutex _mutex;
+        condition_variable _cv;
+        deque<Request> _queue;
+        size_t _queued_positions = 0;
+        bool _stop = false;
+        Stat _stat;
+        vector<thread> _threads;
+
+        void run();
+
+        void run_batch(vector<Request>& batch);
+
+    public:
+        InferenceServer(shared_ptr<IEvaluator<TGame>> evaluator, Config config = Config())
+            : _evaluator(std::move(evaluator)), _config(config) {
+            for (int i = 0; i < max(1, _config.n_threads); i++) {
+                _threads.emplace_back([this]() { run(); });
+            }
+        }
+
+        InferenceServer(const InferenceServer&) = delete;
+        InferenceServer& operator=(const InferenceServer&) = delete;
+
+        // sends what is queued without waiting for deadlines
+        ~InferenceServer() {
+            {
+                lock_guard<mutex> guard(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+            for (auto& t : _threads) {
+                t.join();
+            }
+        }
+
+        Evaluation<TGame> evaluate(const TGame& game) override {
+            return evaluate_async(vector<TGame>{ game }).get()[0];
+        }
+
+        vector<Evaluation<TGame>> evaluate(const vector<TGame*>& games) override {
+            vector<TGame> copies;
+            for (auto* g : games) {
+                copies.push_back(*g);
+            }
+            return evaluate_async(std::move(copies)).get();
+        }
+
+        future<vector<Evaluation<TGame>>> evaluate_async(vector<TGame> games) override {
+            Request req;
+            req.games = std::move(games);
+            req.arrival = Clock::now();
+            auto result = req.result.get_future();
+            {
+                lock_guard<mutex> guard(_mutex);
+                _queued_positions += req.games.size();
+                _queue.push_back(std::move(req));
+            }
+            _cv.notify_one();
+            return result;
+        }
+
+        double busy_seconds() const override {
+            lock_guard<mutex> guard(_mutex);
+            return _stat.busy_seconds / _threads.size();
+        }
+
+        Stat stat() {
+            lock_guard<mutex> guard(_mutex);
+            return _stat;
+        }
+    };
+
+    template<typename TGame>
+    inline void InferenceServer<TGame>::run() {
+        unique_lock<mutex> lock(_mutex);
+        while (true) {
+            if (_queue.empty()) {
+                if (_stop) return;
+                _cv.wait(lock);
+                continue;
+            }
+
+            // wait for the batch to fill, or the oldest request's deadline
+            bool full = _queued_positions >= size_t(_config.max_batch_size);
+            auto deadline = _queue.front().arrival + _config.max_latency;
+            if (!full && !_stop && Clock::now() < deadline) {
+                _cv.wait_until(lock, deadline);
+                continue;
+            }
+
+            // whole requests only; an oversized one goes alone
+            vector<Request> batch;
+            size_t n = 0;
+            while (!_queue.empty() && (batch.empty() || n + _queue.front().games.size() <= size_t(_config.max_batch_size))) {
+                n += _queue.front().games.size();
+                batch.push_back(std::move(_queue.front()));
+                _queue.pop_front();
+            }
+            _queued_positions -= n;
+            if (!_queue.empty()) {
+                _cv.notify_one();
+            }
+
+            lock.unlock();
+            run_batch(batch);
+            lock.lock();
+        }
+    }
+
+    template<typename TGame>
+    inline void InferenceServer<TGame>::run_batch(vector<Request>& batch) {
+        auto start = Clock::now();
+        vector<TGame*> games;
+        for (auto& req : batch) {
+            for (auto& g : req.games) {
+                games.push_back(&g);
+            }
+        }
+
+        vector<Evaluation<TGame>> evals;
+        exception_ptr error;
+        try {
+            evals = _evaluator->evaluate(games);
+            assert(evals.size() == games.size());
+        }
+        catch (...) {
+            error = current_exception();
+        }
+        auto end = Clock::now();
+
+        double latency = 0, max_latency = 0;
+        for (auto& req : batch) {
+            double t = chrono::duration<double>(end - req.arrival).count();
+            latency += t;
+            max_latency = max(max_latency, t);
+        }
+        {
+            lock_guard<mutex> guard(_mutex);
+            _stat.n_requests += batch.size();
+            _stat.n_positions += games.size();
+            _stat.n_batches++;
+            _stat.latency_seconds += latency;
+            _stat.max_latency_seconds = max(_stat.max_latency_seconds, max_latency);
+            _stat.busy_seconds += chrono::duration<double>(end - start).count();
+        }
+
+        size_t offset = 0;
+        for (auto& req : batch) {
+            size_t n = req.games.size();
+            if (error) {
+                req.result.set_exception(error);
+            }
+            else {
+                req.result.set_value(vector<Evaluation<TGame>>(
+                    make_move_iterator(evals.begin() + offset), make_move_iterator(evals.begin() + offset + n)));
+            }
+            offset += n;
+        }
+    }
+}
@@ -2,6 +2,8 @@
 #include <vector>
 #include <cassert>
 #include <string>
+#include <future>
+#include <exception>
 
 namespace Maestro {
     using namespace std;
@@ -44,6 +46,39 @@ namespace Maestro {
         virtual string to_string() const { return "not implemented"; }
     };
 
+    // Symmetries of a game: maps under which positions, and their moves,
+    // are equivalent. Symmetry 0 is the identity. Games without symmetries
+    // use this default.
+    template<typename TGame>
+    struct Symmetry {
+        static constexpr int COUNT = 1;
+        static TGame apply(const TGame& game, int sym) { return game; }
+        static Move<TGame> apply(Move<TGame> mov, int sym) { return mov; }
+        static int inverse(int sym) { return sym; }
+        // the symmetry taking game to the representative of its class
+        static int canonical(const TGame& game) { return 0; }
+    };
+
+    // A game as evaluators see it, for caching their results: besides what
+    // operator== compares, an evaluator may depend on other state of the
+    // game. This default has none; games may specialize it.
+    template<typename TGame>
+    struct EvaluationKey {
+        static size_t hash(const TGame& game) { return game.get_hash(); }
+        static bool equal(const TGame& a, const TGame& b) { return a == b; }
+    };
+
+    // Enumerates the legal moves of a game. This default goes through
+    // get_all_legal_moves(); games may specialize it to avoid allocating.
+    template<typename TGame>
+    struct LegalMoves {
+        static int count(const TGame& game) { return int(game.get_all_legal_moves().size()); }
+        template<typename F>
+        static void for_each(const TGame& game, F f) {
+            for (Move<TGame> m : game.get_all_legal_moves()) f(m);
+        }
+    };
+
     template<typename TGame>
     struct MovePrior {
         Move<TGame> move;
@@ -71,6 +106,7 @@ namespace Maestro {
     template<typename TGame>
     class IEvaluator {
     public:
+        virtual ~IEvaluator() = default;
         // ע⣺
         // vվgameĵǰӽǿģӵһ
         virtual Evaluation<TGame> evaluate(const TGame& game) = 0;
@@ -81,6 +117,25 @@ namespace Maestro {
             }
             return evals;
         }
+        // Starts evaluating a batch and returns a future of the results.
+        // By default the batch is evaluated on the calling thread.
+        virtual future<vector<Evaluation<TGame>>> evaluate_async(vector<TGame> games) {
+            promise<vector<Evaluation<TGame>>> result;
+            try {
+                vector<TGame*> ptrs;
+                for (auto& g : games) {
+                    ptrs.push_back(&g);
+                }
+                result.set_value(evaluate(ptrs));
+            }
+            catch (...) {
+                result.set_exception(current_exception());
+            }
+            return result.get_future();
+        }
+        // Seconds spent evaluating, averaged over the evaluator's threads;
+        // negative if the evaluator does not keep track.
+        virtual double busy_seconds() const { return -1; }
     };
 
     // Sample here
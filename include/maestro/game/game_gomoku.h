@@ -1,7 +1,7 @@
 #pragma once
 #include "game_base.h"
+#include "../util/bitboard.h"
 #include <cassert>
-#include <bitset>
 #include <sstream>
 
 namespace Maestro {
@@ -23,24 +23,37 @@ namespace Maestro {
         Color _color = Color::A;
         Status _status;
         Move<Gomoku> _last_move = { -1,-1 };
+        uint64_t _zobrist = 0;
     public:
         class HalfBoard;
     private:
-        void set_check_interval(int d, int& start, int& end);
-        bool check_dir(const HalfBoard& hb, int dr, int dc);
-        void check_status();
+        int count_dir(const HalfBoard& hb, Move<Gomoku> from, int dr, int dc) const;
+        bool check_line(const HalfBoard& hb, Move<Gomoku> mov, int dr, int dc) const;
+        void update_status(Color mover, Move<Gomoku> mov);
 
     public:
         class HalfBoard {
-            bitset<256> _stones = 0;
+            Bits256 _stones;
             static int idx(uint8_t row, uint8_t col) {
                 assert(row < BOARD_SIZE);
                 assert(col < BOARD_SIZE);
                 return (row << 4) | col;
             }
         public:
-            bool operator==(const HalfBoard& bb) const { return (_stones ^ bb._stones).none(); }
-            bool get(uint8_t row, uint8_t col) const { return _stones[idx(row, col)]; }
+            // index strides of the four line directions; column 15 and row 15
+            // are never set, so shifted runs cannot wrap across the board edge
+            static constexpr int STRIDE_ROW = 1;
+            static constexpr int STRIDE_COL = 16;
+            static constexpr int STRIDE_DIAG = 17;
+            static constexpr int STRIDE_ANTI_DIAG = 15;
+
+            static int stride(int dr, int dc) { return dr * 16 + dc; }
+
+            HalfBoard() = default;
+            explicit HalfBoard(const Bits256& stones) : _stones(stones) {}
+
+            bool operator==(const HalfBoard& bb) const { return _stones == bb._stones; }
+            bool get(uint8_t row, uint8_t col) const { return _stones.test(idx(row, col)); }
             bool get(Move<Gomoku> mov) const { return get(mov.row, mov.col); }
             bool safe_get(int8_t row, int8_t col) const {
                 if ((row < 0) | (col < 0) | (row >= BOARD_SIZE) | (col >= BOARD_SIZE)) return false;
@@ -49,25 +62,98 @@ namespace Maestro {
             bool safe_get(Move<Gomoku> mov) const {
                 return safe_get(mov.row, mov.col);
             }
-            void set(uint8_t row, uint8_t col, bool value) { _stones[idx(row, col)] = value; }
+            void set(uint8_t row, uint8_t col, bool value) { _stones.set(idx(row, col), value); }
             void set(Move<Gomoku> mov, bool value) { set(mov.row, mov.col, value); }
-            size_t get_hash() const {
-                hash<decltype(_stones)> hash_fn;
-                return hash_fn(_stones);
-            }
+            const Bits256& bits() const { return _stones; }
             bool could_transfer_to(const HalfBoard& hb) const {
-                bitset<256> res = _stones;
-                res.flip();
-                res |= hb._stones;
-                return res.all();
+                return _stones.and_not(hb._stones).none();
             }
+
+            // bit i is set iff a run of at least k stones starts at cell i along stride D
+            template<int D>
+            Bits256 run_starts(int k) const {
+                Bits256 r = _stones;
+                for (int n = 1; n < k && r.any(); n++) {
+                    r &= r.template shr<D>();
+                }
+                return r;
+            }
+
+            // bit i is set iff a winning line starts at cell i along stride D,
+            // i.e. exactly five stones unless SIX_WIN
+            template<int D>
+            Bits256 five_starts() const {
+                const Bits256& s = _stones;
+                Bits256 r2 = s & s.template shr<D>();
+                Bits256 r4 = r2 & r2.template shr<2 * D>();
+                Bits256 r5 = r4 & s.template shr<4 * D>();
+                if (SIX_WIN) return r5;
+                return r5.and_not(s.template shl<D>() | s.template shr<5 * D>());
+            }
+
+            bool has_five() const {
+                return (five_starts<STRIDE_ROW>() |
+                    five_starts<STRIDE_COL>() |
+                    five_starts<STRIDE_DIAG>() |
+                    five_starts<STRIDE_ANTI_DIAG>()).any();
+            }
+
+            // length of the longest run along (dr, dc), capped at `cap`
+            int longest_run(int dr, int dc, int cap = 5) const;
+
+            // the stones under symmetry sym, see Symmetry<Gomoku>
+            HalfBoard transformed(int sym) const;
         } black, white;
 
+        // on-board cells in the layout of HalfBoard
+        static Bits256 board_cells() {
+            return Bits256(0x7FFF7FFF7FFF7FFF, 0x7FFF7FFF7FFF7FFF, 0x7FFF7FFF7FFF7FFF, 0x00007FFF7FFF7FFF);
+        }
+        static int cell_index(Move<Gomoku> m) { return (m.row << 4) | m.col; }
+        static Move<Gomoku> cell_move(int i) { return Move<Gomoku>{ i >> 4, i & 15 }; }
+        // the cells within distance 1 of some cell of cells, on the board
+        static Bits256 dilate(const Bits256& cells);
+
+        // A set of cells read as moves, iterated in row-major order without
+        // allocating.
+        class MoveSet {
+            Bits256 _cells;
+        public:
+            class iterator {
+                Bits256::iterator _it;
+            public:
+                explicit iterator(Bits256::iterator it) : _it(it) {}
+                Move<Gomoku> operator*() const { return cell_move(*_it); }
+                iterator& operator++() { ++_it; return *this; }
+                bool operator!=(const iterator& it) const { return _it != it._it; }
+            };
+
+            explicit MoveSet(const Bits256& cells) : _cells(cells) {}
+            iterator begin() const { return iterator(_cells.begin()); }
+            iterator end() const { return iterator(_cells.end()); }
+            int size() const { return _cells.count(); }
+            bool contains(Move<Gomoku> m) const { return _cells.test(cell_index(m)); }
+            const Bits256& cells() const { return _cells; }
+        };
+
         void move(Move<Gomoku> mov) override;
 
+        // full-board rescan; move() only checks the lines through the last move,
+        // this is kept as the reference implementation
+        Status check_status() const;
+
         Color get_color() const override { return _color; }
+        // { -1, -1 } before the first move
+        Move<Gomoku> get_last_move() const { return _last_move; }
         Status get_status() const override { return _status; }
-        size_t get_hash() const override { return hash<int>()(_steps) ^ black.get_hash() ^ white.get_hash(); }
+        // Zobrist key of the stones, updated by move(); stones placed directly
+        // through black/white are not accounted for
+        size_t get_hash() const override { return size_t(_zobrist); }
+        uint64_t get_zobrist() const { return _zobrist; }
+        static uint64_t zobrist_key(Color color, Move<Gomoku> mov);
+
+        // the position under symmetry sym, with the same side to move
+        Gomoku transformed(int sym) const;
 
         bool is_legal_move(Move<Gomoku> m) const override {
             assert(!_status.end);
@@ -79,6 +165,12 @@ namespace Maestro {
             return (!black.get(m) && !white.get(m));
         }
 
+        Bits256 empty_cells() const { return board_cells().and_not(black.bits() | white.bits()); }
+        // empty cells, or none once the game is over
+        MoveSet legal_moves() const { return MoveSet(_status.end ? Bits256() : empty_cells()); }
+        // empty cells within distance d of a stone, a diagonal step counting as one
+        Bits256 neighbourhood(int d) const;
+
         vector<Move<Gomoku>> get_all_legal_moves() const override;
 
         bool could_transfer_to(const Gomoku& another) const override {
@@ -90,4 +182,46 @@ namespace Maestro {
 
         string to_string() const override;
     };
+
+    // The eight symmetries of the board: bit 2 transposes, then bit 0
+    // mirrors the columns and bit 1 the rows.
+    template<>
+    struct Symmetry<Gomoku> {
+        static constexpr int COUNT = 8;
+        static Gomoku apply(const Gomoku& game, int sym) { return game.transformed(sym); }
+        static Move<Gomoku> apply(Move<Gomoku> mov, int sym) {
+            if (sym & 4) swap(mov.row, mov.col);
+            if (sym & 1) mov.col = BOARD_SIZE - 1 - mov.col;
+            if (sym & 2) mov.row = BOARD_SIZE - 1 - mov.row;
+            return mov;
+        }
+        // a transpose after the mirrors exchanges which of them applies
+        static int inverse(int sym) {
+            return sym & 4 ? 4 | (sym & 1) << 1 | (sym & 2) >> 1 : sym;
+        }
+        // the symmetry giving the smallest (black, white) bitboards
+        static int canonical(const Gomoku& game);
+    };
+
+    template<>
+    struct LegalMoves<Gomoku> {
+        static int count(const Gomoku& game) { return game.legal_moves().size(); }
+        template<typename F>
+        static void for_each(const Gomoku& game, F f) {
+            game.legal_moves().cells().for_each([&f](int i) { f(Gomoku::cell_move(i)); });
+        }
+    };
+
+    // the network input has a plane for the last move, which operator== ignores
+    template<>
+    struct EvaluationKey<Gomoku> {
+        static size_t hash(const Gomoku& game) {
+            Move<Gomoku> last = game.get_last_move();
+            uint64_t m = last.row < 0 ? 0 : uint64_t(Gomoku::cell_index(last) + 1) * 0x9E3779B97F4A7C15;
+            return size_t(game.get_zobrist() ^ m);
+        }
+        static bool equal(const Gomoku& a, const Gomoku& b) {
+            return a == b && a.get_last_move() == b.get_last_move();
+        }
+    };
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace Maestro {
+    using namespace std;
+
+    // Elo difference of a player over its opponent, with the bounds of a
+    // confidence interval. Scores count wins 1 and draws 1/2; half a win
+    // and half a loss are added to the counts so that one-sided results
+    // stay finite.
+    struct EloEstimate {
+        double elo = 0, lower = 0, upper = 0;
+        // mean score and its variance per round
+        double score = 0.5, variance = 0;
+
+        // z is the normal quantile of the interval, 1.96 for 95%
+        static EloEstimate from(int wins, int losses, int draws, double z = 1.96);
+    };
+
+    // expected score of a player elo points stronger, and back
+    double elo_to_score(double elo);
+    double score_to_elo(double score);
+
+    // Sequential probability ratio test of H0: the Elo difference is elo0,
+    // against H1: it is elo1, on the normal approximation of the log
+    // likelihood ratio. Decides once the ratio leaves the bounds given by
+    // the error rates alpha (accepting H1 when H0 holds) and beta.
+    class Sprt {
+    public:
+        struct Config {
+            double elo0 = 0, elo1 = 10;
+            double alpha = 0.05, beta = 0.05;
+        };
+
+        enum class Result {
+            Continue, H0, H1
+        };
+
+        Sprt() = default;
+        explicit Sprt(Config config) : _config(config) {}
+
+        double llr(int wins, int losses, int draws) const;
+        double lower_bound() const;
+        double upper_bound() const;
+        Result test(int wins, int losses, int draws) const;
+        static const char* name(Result result);
+
+        const Config& config() const { return _config; }
+
+    private:
+        Config _config;
+    };
+}
@@ -1,6 +1,12 @@
+#pragma once
 #include "round.h"
+#include "elo.h"
 #include <functional>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
 
 namespace Maestro {
     using namespace std;
@@ -8,65 +14,192 @@ namespace Maestro {
     struct MatchStat {
         int total = 0, current = 1;
         int p1_win = 0, p2_win = 0, draw = 0;
+
+        // of p1 over p2
+        EloEstimate elo() const { return EloEstimate::from(p1_win, p2_win, draw); }
     };
 
+    // Plays n_rounds rounds between the players made by p1_creator and
+    // p2_creator, which swap sides every round. Every round gets a fresh
+    // pair of players. step() plays the next round on the calling thread;
+    // step_to_end() plays all that are left on n_threads threads at once.
+    // The creators are never called concurrently, but the players they
+    // return are used concurrently and must not share state unguarded:
+    // a shared evaluator or evaluation cache has to be thread safe.
+    // With an Sprt the match stops starting rounds once the test decides
+    // whether p1 is stronger; rounds already started are still counted,
+    // but cannot change the decision.
+    // Exceptions thrown by the players or the creators propagate out of
+    // step() and step_to_end().
     template<typename TGame>
     class Match {
-        function<shared_ptr<IPlayer<TGame>>()> _p1_creator, _p2_creator;
-        shared_ptr<IPlayer<TGame>> _p1, _p2;
-        MatchStat _mstat;
-
     public:
+        struct Config {
+            // rounds played at once by step_to_end()
+            int n_threads = 1;
+            // print neither the final boards nor the running score
+            bool quiet = false;
+            // tests p1 against p2 after every round; null plays them all
+            shared_ptr<Sprt> sprt;
+            // Receives a JSON object per line: one with the score after
+            // every round, and a last one once the match ends. Flushed
+            // line by line, so it can be followed while the match runs.
+            FILE* json = nullptr;
+        };
 
+    private:
+        Config _config;
+        function<shared_ptr<IPlayer<TGame>>()> _p1_creator, _p2_creator;
+        shared_ptr<IPlayer<TGame>> _p1, _p2;
+        int _total;
+        // next round to start, rounds counted from 1
+        atomic<int> _next{ 1 };
+        atomic<int> _finished{ 0 }, _p1_win{ 0 }, _p2_win{ 0 }, _draw{ 0 };
+        // no more rounds are started once the Sprt decides or a round throws
+        atomic<bool> _stopped{ false };
+        Sprt::Result _decision = Sprt::Result::Continue;
+        // guards the creators, _p1, _p2, the decision and the output
+        mutex _mutex;
 
-        Match(int n_rounds, function<shared_ptr<IPlayer<TGame>>()> p1_creator, function<shared_ptr<IPlayer<TGame>>()> p2_creator)
-            : _p1_creator(move(p1_creator)), _p2_creator(move(p2_creator)) {
-            if (n_rounds % 2 == 1) ++n_rounds;
-            _mstat.total = n_rounds;
+        // called with _mutex held
+        void report(int round, bool swap_side, Color winner, const TGame& game) {
+            MatchStat s = stat();
+            EloEstimate e = s.elo();
+            double llr = 0;
+            if (_config.sprt) {
+                llr = _config.sprt->llr(s.p1_win, s.p2_win, s.draw);
+                // latched: rounds that were already running when the test
+                // decided must not move the LLR back across a bound
+                if (_decision == Sprt::Result::Continue) {
+                    _decision = _config.sprt->test(s.p1_win, s.p2_win, s.draw);
+                    if (_decision != Sprt::Result::Continue) _stopped = true;
+                }
+            }
+            if (_config.json) {
+                const char* result = winner == Color::None ? "draw" : (winner == Color::A) != swap_side ? "p1" : "p2";
+                fprintf(_config.json, "{\"event\":\"round\",\"round\":%d,\"p1_first\":%s,\"result\":\"%s\","
+                    "\"p1_win\":%d,\"p2_win\":%d,\"draw\":%d,\"elo\":%.2f,\"elo_lower\":%.2f,\"elo_upper\":%.2f,"
+                    "\"llr\":%.4f,\"sprt\":\"%s\"}\n",
+                    round, swap_side ? "false" : "true", result, s.p1_win, s.p2_win, s.draw, e.elo, e.lower, e.upper,
+                    llr, Sprt::name(_decision));
+                fflush(_config.json);
+            }
+            if (!_config.quiet) {
+                puts(game.to_string().c_str());
+                printf("p1=%d, p2=%d, draw=%d, elo=%.1f [%.1f, %.1f]", s.p1_win, s.p2_win, s.draw, e.elo, e.lower, e.upper);
+                if (_config.sprt) printf(", llr=%.2f (%.2f, %.2f)", llr, _config.sprt->lower_bound(), _config.sprt->upper_bound());
+                printf("\n");
+            }
         }
 
-        bool step() {
-            if (_mstat.current > _mstat.total) return false;
-            _p1 = _p1_creator();
-            _p2 = _p2_creator();
-
-            auto pa = _p1, pb = _p2;
-            bool swap_side = _mstat.current % 2 == 0;
+        void play(int round) {
+            shared_ptr<IPlayer<TGame>> pa, pb;
+            {
+                lock_guard<mutex> lock(_mutex);
+                _p1 = _p1_creator();
+                _p2 = _p2_creator();
+                pa = _p1;
+                pb = _p2;
+            }
+            bool swap_side = round % 2 == 0;
             if (swap_side) swap(pa, pb);
 
             auto r = Round<TGame>(TGame(), move(pa), move(pb));
             r.step_to_end();
-            puts(r.game().to_string().c_str());
             Color winner = r.game().get_status().winner;
-            int a_win = 0, b_win = 0, draw = 0;
+            lock_guard<mutex> lock(_mutex);
             if (winner == Color::None) {
-                ++draw;
+                ++_draw;
             }
-            else if (winner == Color::A) {
-                ++a_win;
+            else if ((winner == Color::A) != swap_side) {
+                ++_p1_win;
             }
-            else if (winner == Color::B) {
-                ++b_win;
+            else {
+                ++_p2_win;
             }
+            ++_finished;
+            report(round, swap_side, winner, r.game());
+        }
 
-            ++_mstat.current;
-            _mstat.draw += draw;
-            _mstat.p1_win += !swap_side ? a_win : b_win;
-            _mstat.p2_win += !swap_side ? b_win : a_win;
-            printf("p1=%d, p2=%d, draw=%d\n", _mstat.p1_win, _mstat.p2_win, _mstat.draw);
+    public:
+        Match(int n_rounds, function<shared_ptr<IPlayer<TGame>>()> p1_creator, function<shared_ptr<IPlayer<TGame>>()> p2_creator,
+            Config config = Config())
+            : _config(config), _p1_creator(move(p1_creator)), _p2_creator(move(p2_creator)) {
+            if (n_rounds % 2 == 1) ++n_rounds;
+            _total = n_rounds;
+        }
+
+        bool step() {
+            if (_stopped) return false;
+            int round = _next++;
+            if (round > _total) return false;
+            play(round);
             return true;
         }
 
+        // A round that throws stops the others from starting; the first
+        // exception is rethrown once every thread has been joined.
         void step_to_end() {
-            while (step()) {}
-            printf("match end! p1=%d, p2=%d, draw=%d\n", _mstat.p1_win, _mstat.p2_win, _mstat.draw);
+            int n_threads = max(1, _config.n_threads);
+            vector<exception_ptr> errors(n_threads);
+            auto run = [this, &errors](int i) {
+                try {
+                    while (step()) {}
+                }
+                catch (...) {
+                    errors[i] = current_exception();
+                    _stopped = true;
+                }
+            };
+            vector<thread> workers;
+            for (int i = 1; i < n_threads; i++) {
+                workers.emplace_back(run, i);
+            }
+            run(0);
+            for (auto& t : workers) {
+                t.join();
+            }
+            for (auto& e : errors) {
+                if (e) rethrow_exception(e);
+            }
+            MatchStat s = stat();
+            EloEstimate e = s.elo();
+            if (_config.json) {
+                fprintf(_config.json, "{\"event\":\"end\",\"rounds\":%d,\"p1_win\":%d,\"p2_win\":%d,\"draw\":%d,"
+                    "\"elo\":%.2f,\"elo_lower\":%.2f,\"elo_upper\":%.2f,\"sprt\":\"%s\"}\n",
+                    s.current - 1, s.p1_win, s.p2_win, s.draw, e.elo, e.lower, e.upper, Sprt::name(decision()));
+                fflush(_config.json);
+            }
+            if (!_config.quiet) {
+                printf("match end! p1=%d, p2=%d, draw=%d, elo=%.1f [%.1f, %.1f]", s.p1_win, s.p2_win, s.draw, e.elo, e.lower, e.upper);
+                if (_config.sprt) printf(", sprt %s", Sprt::name(decision()));
+                printf("\n");
+            }
         }
 
-        const MatchStat& stat() {
-            return _mstat;
+        // the score so far; current is the number of the next round
+        MatchStat stat() const {
+            MatchStat s;
+            s.total = _total;
+            s.current = _finished + 1;
+            s.p1_win = _p1_win;
+            s.p2_win = _p2_win;
+            s.draw = _draw;
+            return s;
+        }
+
+        const Config& config() const { return _config; }
+
+        // the outcome of the Sprt, Continue until it decides; fixed from then on
+        Sprt::Result decision() {
+            lock_guard<mutex> lock(_mutex);
+            return _decision;
         }
 
-        const shared_ptr<IPlayer<TGame>>& player(int no) {
+        // the players of the round started last; a copy, since the workers
+        // replace them as they start rounds
+        shared_ptr<IPlayer<TGame>> player(int no) {
+            lock_guard<mutex> lock(_mutex);
             if (no == 1) {
                 return _p1;
             }
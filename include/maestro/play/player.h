@@ -1,6 +1,9 @@
+#pragma once
 #include "../search/search_base.h"
 #include "../game/game_gomoku.h"
+#include "time_manager.h"
 #include <iostream>
+#include <thread>
 
 namespace Maestro {
     using namespace std;
@@ -13,26 +16,119 @@ namespace Maestro {
         virtual ~IPlayer() = default;
     };
 
+    // With ponder set, the player keeps searching on a background thread
+    // from the moment its own move is played until the opponent's reply
+    // arrives in move(), which stops the search and keeps the subtree of
+    // the reply. Pondering stops by itself after max_ponder_sims.
+    // After set_clock() moves are timed by a TimeManager instead of taking
+    // n_sim simulations each.
     template<typename TGame>
     class MonteCarloAIPlayer final : public IPlayer<TGame> {
+        static constexpr int PONDER_CHUNK = 256;
+
         shared_ptr<IMonteCarloSearch<TGame>> _search;
         int _n_sim;
+        bool _ponder;
+        int _max_ponder_sims;
+        // set between get_move() and the move() playing its result
+        bool _own_move = false;
+        thread _ponder_thread;
+        atomic<int> _ponder_sims{ 0 }, _total_sims{ 0 };
+        bool _timed = false;
+        double _clock = 0, _increment = 0;
+        TimeManager _time_manager;
+        SearchReport _last_report;
+
+        static chrono::steady_clock::duration seconds(double t) {
+            return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(t));
+        }
+
+        int timed_search() {
+            auto start = chrono::steady_clock::now();
+            double nominal = _time_manager.nominal(_clock, _increment);
+            SearchBudget budget;
+            budget.deadline = start + seconds(_time_manager.first_search(nominal));
+            _last_report = _search->search(budget);
+            int sims = _last_report.sims;
+
+            double move_time = _time_manager.move_time(nominal, _last_report);
+            budget.deadline = start + seconds(move_time);
+            if (chrono::steady_clock::now() < budget.deadline) {
+                sims += _search->search(budget).sims;
+            }
+
+            _clock += _increment - chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            return sims;
+        }
+
+        void start_ponder() {
+            if (_search->get_game_snapshot().get_status().end) return;
+            _search->resume();
+            _ponder_thread = thread([this]() {
+                int sims = 0;
+                while (!_search->stopped() && sims < _max_ponder_sims) {
+                    sims += _search->simulate(min(PONDER_CHUNK, _max_ponder_sims - sims));
+                }
+                _ponder_sims += sims;
+                _total_sims += sims;
+            });
+        }
+
+        void stop_ponder() {
+            if (!_ponder_thread.joinable()) return;
+            _search->stop();
+            _ponder_thread.join();
+            _search->resume();
+        }
+
     public:
-        MonteCarloAIPlayer(shared_ptr<IMonteCarloSearch<TGame>> search, int n_sim) : _search(std::move(search)), _n_sim(n_sim) {
+        MonteCarloAIPlayer(shared_ptr<IMonteCarloSearch<TGame>> search, int n_sim, bool ponder = false, int max_ponder_sims = 0) :
+            _search(std::move(search)), _n_sim(n_sim), _ponder(ponder),
+            _max_ponder_sims(max_ponder_sims > 0 ? max_ponder_sims : 4 * n_sim) {
 
         }
 
+        ~MonteCarloAIPlayer() {
+            stop_ponder();
+        }
+
         virtual Move<TGame> get_move(const TGame& game) {
+            stop_ponder();
             assert(game == _search->get_game_snapshot());
-            _search->simulate(_n_sim);
+            _total_sims += _timed ? timed_search() : _search->simulate(_n_sim);
             auto m = _search->pick_move(0.0f);
+            _own_move = true;
             return m;
         }
 
         virtual void move(Move<TGame> m) {
+            stop_ponder();
             _search->move(m);
+            if (_ponder && _own_move) {
+                start_ponder();
+            }
+            _own_move = false;
         }
 
+        // Plays the following moves on a clock of clock_seconds, which gains
+        // increment_seconds after each move.
+        void set_clock(double clock_seconds, double increment_seconds, TimeManager time_manager = TimeManager()) {
+            _timed = true;
+            _clock = clock_seconds;
+            _increment = increment_seconds;
+            _time_manager = time_manager;
+        }
+
+        // time left on the clock, negative once exceeded
+        double clock() const { return _clock; }
+
+        // report of the first search of the last timed move
+        const SearchReport& last_report() const { return _last_report; }
+
+        // simulations run while the opponent was to move, and in total
+        int ponder_simulations() const { return _ponder_sims; }
+        int simulations() const { return _total_sims; }
+
         shared_ptr<IMonteCarloSearch<TGame>> search() const {
             return _search;
         }
@@ -1,3 +1,4 @@
+#pragma once
 #include "player.h"
 
 namespace Maestro {
@@ -19,14 +20,12 @@ namespace Maestro {
                 return false;
             }
             Color c = _game.get_color();
-            Move<Gomoku> m;
+            Move<TGame> m;
             if (c == Color::A) {
                 m = _pa->get_move(_game);
-                _pb->get_move(_game);
             }
             else if (c == Color::B) {
                 m = _pb->get_move(_game);
-                _pa->get_move(_game);
             }
             else {
                 throw runtime_error("unexpected color none");
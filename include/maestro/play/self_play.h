@@ -0,0 +1,60 @@
+#pragma once
+#include "round.h"
+#include "training_data.h"
+#include "../search/search_graph.h"
+#include <string>
+
+namespace Maestro {
+    using namespace std;
+
+    // Plays games of a search against itself on n_threads threads and
+    // appends a GomokuRecord per position to one file per thread,
+    // <prefix>-<thread>.bin. Each side has its own search, which keeps its
+    // subtree across moves as in a Match. The first sample_plies moves of a
+    // game are drawn in proportion to the visits, the others are the most
+    // visited. Game i is seeded from seed and i, so a run is reproducible
+    // up to the order in which the threads pick up the games.
+    class SelfPlay {
+    public:
+        struct Config {
+            int n_threads = 1;
+            int n_sim = 800;
+            int sample_plies = 8;
+            uint32_t seed = 0;
+            // the searches of both sides; every search is reseeded, so
+            // same_response only matters for its construction
+            MonteCarloGraphSearch<Gomoku>::Config search;
+
+            // two searches are made per game on every thread, so their tables
+            // are sized for a game of n_sim in the thousands rather than for
+            // a long analysis; raise search.tt_capacity along with n_sim
+            Config() { search.tt_capacity = 1 << 16; }
+        };
+
+        struct Stat {
+            int games = 0, black_win = 0, white_win = 0, draw = 0;
+            int64_t positions = 0;
+            double seconds = 0;
+            double positions_per_sec() const { return seconds > 0 ? positions / seconds : 0; }
+            void print() const {
+                printf("self-play: games=%d (black=%d, white=%d, draw=%d), positions=%lld, positions/sec=%.1f\n",
+                    games, black_win, white_win, draw, (long long)positions, positions_per_sec());
+            }
+        };
+
+        SelfPlay(shared_ptr<IEvaluator<Gomoku>> evaluator, string prefix);
+        SelfPlay(shared_ptr<IEvaluator<Gomoku>> evaluator, string prefix, Config config);
+
+        // Plays n_games games and returns their stat. Throws runtime_error
+        // if a shard cannot be opened for appending.
+        Stat play(int n_games);
+
+        string shard_path(int thread) const;
+        const Config& config() const { return _config; }
+
+    private:
+        shared_ptr<IEvaluator<Gomoku>> _evaluator;
+        string _prefix;
+        Config _config;
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "../search/search_base.h"
+
+namespace Maestro {
+    using namespace std;
+
+    // Splits a clock into per-move times. A move first searches for part of
+    // its nominal share of the clock; the report of that search then sets
+    // how long the whole move may take. Moves whose visits concentrate on
+    // one reply stop early, and uncertain positions, with spread out visits
+    // or an unsettled value, get more than the nominal time.
+    class TimeManager {
+    public:
+        struct Config {
+            // moves the remaining clock is expected to last for
+            double moves_to_go = 30;
+            // part of each increment spent on the move it comes with
+            double increment_use = 0.8;
+            // never plan to use more of the remaining clock than this, or
+            // to leave less than safety_seconds on it
+            double max_clock_share = 0.4;
+            double safety_seconds = 0.05;
+            // part of the nominal time searched before the report is read
+            double first_part = 0.5;
+            // bounds of the move time relative to the nominal time
+            double min_factor = 0.25, max_factor = 3;
+            // best visit share from which a move counts as forced
+            float forced_share = 0.9f;
+            // value standard deviation counted as fully unsettled
+            float unsettled_stddev = 0.1f;
+        };
+
+        TimeManager() = default;
+        explicit TimeManager(Config config) : _config(config) {}
+
+        // nominal time of the next move in seconds
+        double nominal(double clock_seconds, double increment_seconds) const;
+
+        // time of the first search of a move
+        double first_search(double nominal) const { return nominal * _config.first_part; }
+
+        // time the whole move may take after a first search with this report;
+        // at most the first search time for forced moves
+        double move_time(double nominal, const SearchReport& first) const;
+
+        const Config& config() const { return _config; }
+
+    private:
+        Config _config;
+    };
+}
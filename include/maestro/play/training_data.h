@@ -0,0 +1,83 @@
+#pragma once
+#include "../game/game_gomoku.h"
+#include "../search/search_base.h"
+#include <cstdio>
+#include <string>
+
+namespace Maestro {
+    using namespace std;
+
+    // One position of a self-play game: the stones, the visit distribution
+    // of the search from it, and the outcome of the game. Fixed size and
+    // without pointers, so a file of records can be read by a trainer in
+    // bulk or mapped into memory as an array.
+    struct GomokuRecord {
+        // bitboard words of each side, in the layout of Gomoku::HalfBoard
+        uint64_t black[4], white[4];
+        // value of the search for the player to move
+        float search_value;
+        // visit share of each move in 1/65535, indexed by row * BOARD_SIZE + col
+        uint16_t policy[BOARD_SIZE * BOARD_SIZE];
+        // 1 if the player to move went on to win, -1 if it lost, 0 for a draw
+        int8_t outcome;
+        // 1 if black is to move, 0 if white
+        uint8_t black_to_move;
+        // the move leading here, -1 before the first move
+        int8_t last_row, last_col;
+        uint8_t reserved[6];
+
+        // the position and its search, the outcome is filled in later
+        static GomokuRecord from(const Gomoku& game, const vector<MoveVisit<Gomoku>>& visits, float search_value);
+    };
+    static_assert(sizeof(GomokuRecord) == 528, "record layout is part of the file format");
+
+    // A record file is this header followed by records, little-endian as
+    // written, with nothing in between.
+    struct TrainingFileHeader {
+        static const uint32_t VERSION = 1;
+        char magic[8] = { 'M', 'A', 'E', 'S', 'T', 'R', 'O', 'R' };
+        uint32_t version = VERSION;
+        uint32_t record_size = sizeof(GomokuRecord);
+    };
+    static_assert(sizeof(TrainingFileHeader) == 16, "header layout is part of the file format");
+
+    // Appends records to a file, writing the header if the file is new.
+    // A partial record at the end of an existing file, left by a writer
+    // that died mid-write, is cut off before appending.
+    // Throws runtime_error if an existing file has another format.
+    class TrainingDataWriter {
+        FILE* _file = nullptr;
+        size_t _written = 0;
+    public:
+        explicit TrainingDataWriter(const string& path);
+        ~TrainingDataWriter();
+        TrainingDataWriter(const TrainingDataWriter&) = delete;
+        TrainingDataWriter& operator=(const TrainingDataWriter&) = delete;
+
+        void write(const GomokuRecord* records, size_t n);
+        void flush();
+        // records written through this writer
+        size_t written() const { return _written; }
+    };
+
+    // Reads the records of a file in order through a fixed buffer.
+    // Throws runtime_error on a bad header or a truncated record.
+    class TrainingDataReader {
+        FILE* _file = nullptr;
+        size_t _size = 0;
+        vector<GomokuRecord> _buffer;
+        size_t _pos = 0, _end = 0;
+    public:
+        explicit TrainingDataReader(const string& path, size_t buffer_records = 1024);
+        ~TrainingDataReader();
+        TrainingDataReader(const TrainingDataReader&) = delete;
+        TrainingDataReader& operator=(const TrainingDataReader&) = delete;
+
+        // false at the end of the file
+        bool next(GomokuRecord& record);
+        // copies up to n records to out and returns how many
+        size_t read(GomokuRecord* out, size_t n);
+        // records in the file when it was opened
+        size_t size() const { return _size; }
+    };
+}
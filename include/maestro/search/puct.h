@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+namespace Maestro {
+    using namespace std;
+
+    // Selection statistics of 8 sibling edges, stored field by field so that
+    // each field of a lane fills one AVX register. A state with n children
+    // owns (n + 7) / 8 consecutive lanes; slot i lives in lane i >> 3.
+    struct alignas(32) EdgeLane {
+        // prior, including root noise
+        float p[8] = {};
+        // child value from the parent's point of view, 0 if the child is absent
+        float q[8] = {};
+        int32_t visit[8] = {};
+        // pending virtual losses through the edge
+        int32_t vl[8] = {};
+    };
+
+    // q of the unused slots in a state's last lane, so they are never selected
+    const float EDGE_PAD_Q = -1e30f;
+
+    inline int edge_lane_count(int n) { return (n + 7) >> 3; }
+
+    // Marks slots n and above of the last lane as padding.
+    void pad_edge_lanes(EdgeLane* lanes, int n);
+
+    // PUCT score of slot i:
+    //   1 + q - vl * virtual_loss / max(1, visit) + c * p / (1 + visit)
+    // where c is the exploration constant times sqrt of the parent's visits.
+
+    // Index of the highest scoring of n edges, the last one on ties.
+    int puct_argmax(const EdgeLane* lanes, int n, float c, float virtual_loss);
+
+    // Writes the scores of n edges to out.
+    void puct_scores(const EdgeLane* lanes, int n, float c, float virtual_loss, float* out);
+
+    // Portable versions of the above, used when AVX2 is unavailable.
+    int puct_argmax_scalar(const EdgeLane* lanes, int n, float c, float virtual_loss);
+    void puct_scores_scalar(const EdgeLane* lanes, int n, float c, float virtual_loss, float* out);
+}
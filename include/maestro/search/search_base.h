@@ -5,6 +5,11 @@
 #include <cassert>
 #include <random>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <algorithm>
 
 namespace Maestro {
     using namespace std;
@@ -21,13 +26,45 @@ namespace Maestro {
         float p;
     };
 
+    // Limits of one call to search(), which stops at the first reached.
+    struct SearchBudget {
+        int max_sims = INT_MAX;
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+        // stop once the most visited root move cannot be overtaken by the
+        // second within the simulations left, as estimated from the rate so far
+        bool early_stop = true;
+    };
+
+    struct SearchReport {
+        int sims = 0;
+        double seconds = 0;
+        bool early_stopped = false;
+        // visit share of the most visited root move
+        float best_share = 0;
+        // entropy of the root visit distribution over log(number of moves), in [0, 1]
+        float visit_entropy = 0;
+        // standard deviation of the root value sampled between chunks
+        float value_stddev = 0;
+    };
+
     template<typename TGame>
     class IMonteCarloSearch {
     protected:
         minstd_rand _rnd_eng;
+        // checked by simulate() between simulations
+        atomic<bool> _stop{ false };
     public:
         virtual ~IMonteCarloSearch() = default;
-        virtual void simulate(int k) = 0;
+        // Runs k simulations, or fewer once stop() is called; returns the
+        // number run.
+        virtual int simulate(int k) = 0;
+        // Makes simulate() return early, from any thread, until resume().
+        void stop() { _stop = true; }
+        void resume() { _stop = false; }
+        bool stopped() const { return _stop; }
+        // Reseeds the generator behind the root noise and pick_move(temp);
+        // searches built with same_response start from the same seed.
+        void seed(uint32_t s) { _rnd_eng.seed(s); }
         virtual vector<MoveVisit<TGame>> get_moves() const = 0;
         virtual float get_value(Color color) const = 0;
         virtual TGame get_game_snapshot() const = 0;
@@ -83,6 +120,79 @@ namespace Maestro {
             }
         }
 
+        // Simulates in chunks until a limit of the budget is reached.
+        SearchReport search(const SearchBudget& budget) {
+            using clock = chrono::steady_clock;
+            SearchReport report;
+            auto start = clock::now();
+            Color color = get_game_snapshot().get_color();
+            int n_values = 0;
+            double value_mean = 0, value_m2 = 0;
+            int chunk = min(32, budget.max_sims);
+
+            while (report.sims < budget.max_sims && clock::now() < budget.deadline && !_stop) {
+                int n = simulate(min(chunk, budget.max_sims - report.sims));
+                if (n == 0) break;
+                report.sims += n;
+
+                // Welford's running variance of the root value
+                double v = get_value(color);
+                n_values++;
+                double delta = v - value_mean;
+                value_mean += delta / n_values;
+                value_m2 += delta * (v - value_mean);
+
+                auto now = clock::now();
+                double elapsed = chrono::duration<double>(now - start).count();
+                double rate = elapsed > 0 ? report.sims / elapsed : 1e9;
+                double sims_left = budget.max_sims - report.sims;
+                if (budget.deadline != clock::time_point::max()) {
+                    double time_left = chrono::duration<double>(budget.deadline - now).count();
+                    sims_left = min(sims_left, max(0.0, rate * time_left));
+                    // about a tenth of what is left, but no more than 20ms of work
+                    chunk = int(clamp(min(sims_left / 10, rate * 0.02), 16.0, max(16.0, sims_left)));
+                }
+                else {
+                    chunk = int(clamp(sims_left / 10, 16.0, max(16.0, sims_left)));
+                }
+
+                if (budget.early_stop) {
+                    int first = 0, second = 0;
+                    for (auto& mv : get_moves()) {
+                        if (mv.visit_count > first) {
+                            second = first;
+                            first = mv.visit_count;
+                        }
+                        else if (mv.visit_count > second) {
+                            second = mv.visit_count;
+                        }
+                    }
+                    if (first - second > sims_left) {
+                        report.early_stopped = true;
+                        break;
+                    }
+                }
+            }
+
+            report.seconds = chrono::duration<double>(clock::now() - start).count();
+            report.value_stddev = n_values > 1 ? float(sqrt(value_m2 / (n_values - 1))) : 0;
+            auto moves = get_moves();
+            double total = 0, best = 0, entropy = 0;
+            for (auto& mv : moves) {
+                total += mv.visit_count;
+                best = max(best, double(mv.visit_count));
+            }
+            for (auto& mv : moves) {
+                if (mv.visit_count > 0) {
+                    double p = mv.visit_count / total;
+                    entropy -= p * log(p);
+                }
+            }
+            report.best_share = total > 0 ? float(best / total) : 0;
+            report.visit_entropy = moves.size() > 1 ? float(entropy / log(double(moves.size()))) : 0;
+            return report;
+        }
+
         void move_best() {
             auto moves = get_moves();
             int max_visit = -1;
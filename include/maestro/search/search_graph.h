@@ -1,7 +1,11 @@
 #pragma once
-#include "../util/lazy.h"
 #include "../util/expirable.h"
+#include "../util/spin_lock.h"
+#include "../util/arena.h"
 #include "search_base.h"
+#include "transposition_table.h"
+#include "puct.h"
+#include "../evaluator/eval_cache.h"
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -9,6 +13,14 @@
 #include <iostream>
 #include <time.h>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <deque>
+#include <future>
 
 namespace Maestro {
     using namespace std;
@@ -28,10 +40,68 @@ namespace Maestro {
             int node_evaluated_total = 0, node_evaluated_used = 0;
             int eval_batch_count = 0;
             float tt_load_factor = 0;
+            size_t tt_replaced = 0;
+            size_t n_states = 0, n_actions = 0;
+            size_t state_size = 0, action_size = 0;
+            size_t mem_arena = 0, mem_tt = 0;
+            int n_threads = 1;
+            double sim_seconds = 0;
+            // time workers spent blocked on evaluation results, summed over workers
+            double eval_wait_seconds = 0;
+            // time the evaluator spent evaluating, averaged over its threads
+            double eval_busy_seconds = 0;
+            int eval_max_in_flight = 0;
+            int eval_cache_lookups = 0, eval_cache_hits = 0;
+            // root moves; states kept and dropped by the last one, and the
+            // time spent in move(), excluding freeing on the background thread
+            int gc_moves = 0;
+            size_t gc_kept = 0, gc_dropped = 0;
+            double gc_seconds = 0, gc_max_seconds = 0;
+            void merge(const GlobalStat& s) {
+                sim_use_transposition += s.sim_use_transposition;
+                sim_game_end += s.sim_game_end;
+                sim_total += s.sim_total;
+                visit_evaluating += s.visit_evaluating;
+                node_evaluated_total += s.node_evaluated_total;
+                node_evaluated_used += s.node_evaluated_used;
+                eval_batch_count += s.eval_batch_count;
+                eval_wait_seconds += s.eval_wait_seconds;
+                eval_busy_seconds += s.eval_busy_seconds;
+                eval_max_in_flight = max(eval_max_in_flight, s.eval_max_in_flight);
+                eval_cache_lookups += s.eval_cache_lookups;
+                eval_cache_hits += s.eval_cache_hits;
+            }
+            // node memory per state including its child actions, excluding
+            // unused chunk space and heap blocks (eval priors, parent lists)
+            double bytes_per_state() const {
+                return n_states > 0 ? double(n_states * state_size + n_actions * action_size) / n_states : 0;
+            }
+            double sims_per_sec() const {
+                return sim_seconds > 0 ? sim_total / sim_seconds : 0;
+            }
+            double eval_utilization() const {
+                return sim_seconds > 0 ? eval_busy_seconds / sim_seconds : 0;
+            }
+            double eval_cache_hit_rate() const {
+                return eval_cache_lookups > 0 ? double(eval_cache_hits) / eval_cache_lookups : 0;
+            }
             void print() const {
                 printf("sims: total=%d, game_end=%d, transposed=%d\n", sim_total, sim_game_end, sim_use_transposition);
                 printf("eval: total=%d, used=%d, batch=%d\n", node_evaluated_total, node_evaluated_used, eval_batch_count);
-                printf("misc: tt_load_factor=%f, visit_evaluating=%d\n", tt_load_factor, visit_evaluating);
+                printf("misc: tt_load_factor=%f, tt_replaced=%zu, visit_evaluating=%d\n", tt_load_factor, tt_replaced, visit_evaluating);
+                printf("perf: threads=%d, sims/sec=%.0f\n", n_threads, sims_per_sec());
+                printf("eval pipeline: utilization=%.1f%%, wait=%.3fs, max_in_flight=%d\n",
+                    100 * eval_utilization(), eval_wait_seconds, eval_max_in_flight);
+                if (eval_cache_lookups > 0) {
+                    printf("eval cache: lookups=%d, hits=%d, hit_rate=%.1f%%\n",
+                        eval_cache_lookups, eval_cache_hits, 100 * eval_cache_hit_rate());
+                }
+                if (gc_moves > 0) {
+                    printf("gc: moves=%d, last kept=%zu dropped=%zu, time mean=%.3fms max=%.3fms\n",
+                        gc_moves, gc_kept, gc_dropped, gc_seconds / gc_moves * 1e3, gc_max_seconds * 1e3);
+                }
+                printf("mem: states=%zu (%zuB), actions=%zu (%zuB), per state=%.0fB, arena=%.1fMB, tt=%.1fMB\n",
+                    n_states, state_size, n_actions, action_size, bytes_per_state(), mem_arena / 1048576.0, mem_tt / 1048576.0);
             }
         } global_stat = GlobalStat();
 
@@ -42,64 +112,91 @@ namespace Maestro {
             int leaf_batch_count = 8;
             float puct = 2;
             float virtual_loss = 1;
+            // number of threads descending the graph in simulate();
+            // with more than one the evaluator is called concurrently
+            int n_threads = 1;
+            // Number of transposition table entries, rounded up. The table is
+            // allocated and cleared with the search; 1 << 20 entries take
+            // 23MB, 1 << 16 take 1.5MB. It wants about one entry per
+            // state held: the simulations of a move plus what move() keeps of
+            // earlier ones. Past that the oldest entries are replaced, which
+            // only loses transpositions. Searches made per game, as in a
+            // Match or SelfPlay, should use far less.
+            size_t tt_capacity = 1 << 20;
+            // batches each worker may have in flight on evaluate_async() while it
+            // keeps descending; 0 evaluates every batch before continuing
+            int eval_queue_depth = 0;
+            // looked up before evaluating a position and filled with the
+            // results; may be shared with other searches
+            shared_ptr<EvaluationCache<TGame>> eval_cache;
+            // release the nodes dropped by move() on a background thread
+            bool background_free = false;
         };
 
     private:
 
         // struct definations
-        struct GameHash {
-            size_t operator()(const TGame& game) const {
-                return game.get_hash();
-            }
-        };
-
         struct Action;
         struct State;
 
-        using Transposition = unordered_map<TGame, shared_ptr<State>, GameHash>;
-        using EvaluationResult = unordered_map<TGame, Evaluation<TGame>, GameHash>;
-
-        struct State : public enable_shared_from_this<State> {
-            bool stop_selection = false;
-            bool evaluated = false;
+        using Transposition = TranspositionTable<NodeId>;
+
+        // Nodes live in NodeArenas and refer to each other by NodeId.
+        // Fields read during selection are atomic so that workers can descend
+        // concurrently. `lock` guards the creation of the child actions, of
+        // their child states and the state's edge lanes; v, dv, parent_actions
+        // and the backup counters are only written while holding _backup_mutex.
+        struct State {
+            NodeId id = NULL_NODE;
+            atomic<bool> stop_selection{ false };
+            atomic<bool> evaluated{ false };
             unique_ptr<Evaluation<TGame>> eval;
             TGame game;
-            int ns = 0;
-            float v = 0;
+            atomic<int> ns{ 0 };
+            atomic<float> v{ 0 };
             Expirable<float> dv;
-            Expirable<int> virtual_loss_cnt;
             bool noise_generated = false;
-            bool evaluating = false;
-
-            vector<weak_ptr<Action>> parent_actions;
-            Lazy<vector<shared_ptr<Action>>> child_actions;
+            atomic<bool> evaluating{ false };
+            SpinLock lock;
+
+            vector<NodeId> parent_actions;
+            // child actions are one contiguous block, created from eval on first use,
+            // together with edge_lane_count(n_actions) lanes of selection statistics
+            NodeId first_action = NULL_NODE;
+            NodeId first_lane = NULL_NODE;
+            int n_actions = 0;
             Expirable<int> backup_visited_child_count;
             Expirable<int> backup_total_child_count;
+            // new id while move() copies the reachable graph
+            NodeId forward = NULL_NODE;
 
             float convert_v(Color color, float v) const {
                 return color == game.get_color() ? v : -v;
             }
 
             float convert_v(State* state) const {
-                return convert_v(state->game.get_color(), state->v);
+                return convert_v(state->game.get_color(), state->v.load(memory_order_relaxed));
             }
         };
 
-        struct Action : public enable_shared_from_this<Action> {
+        // The prior, visit count, child value and virtual loss of an action
+        // are kept in its parent's edge lanes, at slot id - first_action.
+        struct Action {
+            NodeId id = NULL_NODE;
             Move<TGame> move;
-            int visit = 0;
-            float p = 0;
-            float p_noise_delta = 0;
-            weak_ptr<State> parent_state;
-            Lazy<shared_ptr<State>> child_state;
+            NodeId parent_state = NULL_NODE;
+            // created on first selection, under the parent's lock
+            NodeId child_state = NULL_NODE;
         };
 
         Config _config;
 
         // members
-        shared_ptr<State> _root;
+        NodeArena<State> _states;
+        NodeArena<Action> _actions;
+        NodeArena<EdgeLane, 10> _lanes;
+        NodeId _root;
         Transposition _transposition;
-        EvaluationResult _eval_result;
         shared_ptr<IEvaluator<TGame>> _evaluator;
 
         enum class Timeline : int {
@@ -116,64 +213,174 @@ namespace Maestro {
             int time(Timeline tl) { return _timestamp + int(tl); }
         } _timeline;
 
-        vector<State*> _sim_stack;
+        // per-thread scratch state of simulate()
+        struct Worker {
+            vector<State*> sim_stack;
+            // actions whose virtual loss was raised since the last batch
+            vector<Action*> vl_applied;
+            // actions given a child state during this simulation, whose link
+            // into the child's parent_actions waits for the backup
+            vector<Action*> new_links;
+            vector<State*> eval_batch;
+            // the edges taken by this simulation, undone if it is abandoned
+            struct Step {
+                Action* action;
+                int visit;
+                // whether the visit raised the child's ns
+                bool raised;
+            };
+            vector<Step> path;
+            struct Batch {
+                vector<State*> states;
+                vector<Action*> vl_applied;
+                future<vector<Evaluation<TGame>>> evals;
+            };
+            deque<Batch> in_flight;
+            vector<float> scores;
+            vector<int> order;
+            int leaf_batch_count = 0;
+            GlobalStat stat;
+        };
+
+        // a deque, since workers hold futures and cannot be copied on growth
+        deque<Worker> _workers;
         vector<State*> _backup_stack;
+        mutex _backup_mutex;
+        // leaves claimed for evaluation by any worker and not applied yet,
+        // whether their batch was sent or not
+        atomic<int> _leaves_pending{ 0 };
+        // guarded by _backup_mutex
+        int _batches_applied = 0;
+        condition_variable _batch_applied;
+        // frees the arenas dropped by the last move() with background_free
+        thread _reclaimer;
+
+        NodeId create_state(const TGame& game, bool root = false) {
+            auto make = [this, &game]() {
+                NodeId id = _states.alloc();
+                _states[id].id = id;
+                _states[id].game = game;
+                return id;
+            };
+            auto same_game = [this, &game](NodeId id) { return _states[id].game == game; };
 
-        shared_ptr<State> create_state(TGame game, bool root = false) {
-            shared_ptr<State> ss;
             if (_config.enable_dag || root) {
-                const auto& entry = _transposition.find(game);
-                if (entry != _transposition.end()) {
-                    ss = entry->second;
-                }
+                return _transposition.find_or_insert(game.get_hash(), same_game, make);
             }
 
-            if (!ss) {
-                ss = make_shared<State>();
-                ss->game = game;
-                _transposition.insert(pair<TGame, shared_ptr<State>>(game, ss));
-                State* s = ss.get();
-                ss->child_actions = [this, s]() {
-                    vector<shared_ptr<Action>> actions;
-                    assert(s->eval);
-                    for (auto& mp : s->eval->p) {
-                        actions.push_back(create_action(mp.move, s->weak_from_this(), mp.p));
+            // without DAG every path gets its own state, but the first one is
+            // still recorded so move() can reuse it as the new root
+            NodeId id = make();
+            _transposition.find_or_insert(game.get_hash(), same_game, [id]() { return id; });
+            return id;
+        }
+
+        // s->lock must be held
+        Action* child_actions(State* s) {
+            if (s->eval) {
+                int n = int(s->eval->p.size());
+                if (n > 0) {
+                    NodeId first = _actions.alloc(n);
+                    NodeId first_lane = _lanes.alloc(edge_lane_count(n));
+                    EdgeLane* lanes = &_lanes[first_lane];
+                    for (int i = 0; i < n; i++) {
+                        Action& ac = _actions[first + i];
+                        ac.id = first + i;
+                        ac.move = s->eval->p[i].move;
+                        ac.parent_state = s->id;
+                        lanes[i >> 3].p[i & 7] = s->eval->p[i].p;
                     }
-                    s->eval = nullptr;
-                    return actions;
-                };
+                    pad_edge_lanes(lanes, n);
+                    s->first_action = first;
+                    s->first_lane = first_lane;
+                    s->n_actions = n;
+                }
+                s->eval = nullptr;
             }
+            return s->n_actions > 0 ? &_actions[s->first_action] : nullptr;
+        }
 
-            return ss;
+        EdgeLane* edge_lanes(const State* s) {
+            return &_lanes[s->first_lane];
         }
 
-        shared_ptr<Action> create_action(Move<TGame> m, weak_ptr<State> parent, float p) {
-            auto acs = make_shared<Action>();
-            Action* ac = acs.get();
-            ac->move = m;
-            ac->parent_state = parent;
-            ac->p = p;
-            ac->child_state = [this, ac]() {
-                shared_ptr<State> parent = ac->parent_state.lock();
-                assert(parent);
+        // lane and slot of an action's statistics
+        EdgeLane& edge_lane(Action* ac, int& slot) {
+            State* parent = &_states[ac->parent_state];
+            int i = int(ac->id - parent->first_action);
+            slot = i & 7;
+            return _lanes[parent->first_lane + (i >> 3)];
+        }
 
+        // The parent's lock must be held. A new child is linked back to the
+        // parent later, by link_child() under _backup_mutex.
+        State* child_state(Action* ac, Worker& w) {
+            if (ac->child_state == NULL_NODE) {
+                State* parent = &_states[ac->parent_state];
                 TGame game = parent->game; // copy the game
                 game.move(ac->move);
 
-                shared_ptr<State> child = create_state(game);
-                child->parent_actions.push_back(ac->weak_from_this());
-                return child;
-            };
+                NodeId child = create_state(game);
+                ac->child_state = child;
+                int slot;
+                edge_lane(ac, slot).q[slot] = parent->convert_v(&_states[child]);
+                w.new_links.push_back(ac);
+            }
+            return &_states[ac->child_state];
+        }
+
+        // _backup_mutex must be held
+        void link_child(Action* ac) {
+            State* parent = &_states[ac->parent_state];
+            State* child = &_states[ac->child_state];
+            child->parent_actions.push_back(ac->id);
+            // the child may have been backed up since child_state() read its value
+            SpinLockGuard guard(parent->lock);
+            int slot;
+            edge_lane(ac, slot).q[slot] = parent->convert_v(child);
+        }
 
-            return acs;
+        void update_mem_stat() {
+            global_stat.n_states = _states.size();
+            global_stat.n_actions = _actions.size();
+            global_stat.state_size = sizeof(State);
+            global_stat.action_size = sizeof(Action) + sizeof(EdgeLane) / 8;
+            global_stat.mem_arena = _states.bytes() + _actions.bytes() + _lanes.bytes();
+            global_stat.mem_tt = _transposition.bytes();
         }
 
-        float action_ucb(State* parent, Action* action, int ts_virtual_loss);
+        // takes one simulation off a positive counter and never drives it below zero,
+        // so a claim handed back by an abandoned simulation cannot be missed
+        static bool claim_simulation(atomic<int>& sims_left) {
+            int left = sims_left.load();
+            while (left > 0 && !sims_left.compare_exchange_weak(left, left - 1)) {}
+            return left > 0;
+        }
+
+        void run_worker(Worker& w, atomic<int>& sims_left);
+
+        void flush_batch(Worker& w);
+
+        void collect_batches(Worker& w, bool wait);
+
+        void apply_batch(const vector<State*>& states, vector<Evaluation<TGame>>& evals, vector<Action*>& vl_applied);
+
+        void apply_cached(Worker& w);
+
+        // _backup_mutex must be held
+        void set_evaluations(const vector<State*>& states, vector<Evaluation<TGame>>& evals);
+
+        Evaluation<TGame> evaluate_single(const TGame& game);
+
+        void wait_other_batches(Worker& w);
+        void abandon(Worker& w);
 
         void backup_dv(const vector<State*>& origins, Timeline tl = Timeline::origin);
 
         void slow_dfs_traversal(function<void(State*)> fn);
 
+        void compact(NodeId new_root);
+
         vector<float> rand_dirichlet(int n, float concentration);
 
         void generate_root_dirichlet_noise();
@@ -185,33 +392,49 @@ namespace Maestro {
             TGame game,
             Config config = Config()) :
             _config(config),
+            _transposition(config.tt_capacity),
             _evaluator(std::move(evaluator))
         {
             _root = create_state(game, true);
+            update_mem_stat();
 
             if (!_config.same_response) {
-                static int seed;
-                seed += int(time(0));
-                this->_rnd_eng.seed(seed);
+                // searches may be built on several threads at once
+                static atomic<int> seed{ 0 };
+                this->_rnd_eng.seed(seed += int(time(0)));
             }
         }
 
-        virtual void simulate(int k) override;
+        ~MonteCarloGraphSearch() {
+            if (_reclaimer.joinable()) _reclaimer.join();
+        }
+
+        virtual int simulate(int k) override;
 
         virtual vector<MoveVisit<TGame>> get_moves() const override {
             vector<MoveVisit<TGame>> mvs;
-            for (auto& ap : _root->child_actions.value()) {
-                mvs.push_back(MoveVisit<TGame>{ ap->move, ap->visit });
+            const State& root = _states[_root];
+            if (root.eval) {
+                // evaluated but not selected from yet
+                for (auto& mp : root.eval->p) {
+                    mvs.push_back(MoveVisit<TGame>{ mp.move, 0 });
+                }
+            }
+            for (int i = 0; i < root.n_actions; i++) {
+                const Action& ac = _actions[root.first_action + i];
+                const EdgeLane& lane = _lanes[root.first_lane + (i >> 3)];
+                mvs.push_back(MoveVisit<TGame>{ ac.move, lane.visit[i & 7] });
             }
             return mvs;
         }
 
         virtual float get_value(Color color) const override {
-            return  (_root->game.get_color() == color ? 1 : -1) * _root->v;
+            const State& root = _states[_root];
+            return  (root.game.get_color() == color ? 1 : -1) * root.v;
         }
 
         virtual TGame get_game_snapshot() const override {
-            return _root->game;
+            return _states[_root].game;
         }
 
         virtual void move(Move<TGame> move) override;
@@ -221,19 +444,6 @@ namespace Maestro {
         }
     };
 
-    template<typename TGame>
-    inline float MonteCarloGraphSearch<TGame>::action_ucb(State* parent, Action* action, int ts_virtual_loss) {
-
-        float u = 1;
-        if (action->child_state.initialized()) {
-            State* child = action->child_state.value().get();
-            u += parent->convert_v(child);
-            u -= child->virtual_loss_cnt(ts_virtual_loss) * _config.virtual_loss / max(1, child->ns);
-        }
-        u += _config.puct * (action->p + action->p_noise_delta) * sqrtf(parent->ns) / (1 + action->visit);
-        return u;
-    }
-
     template<typename TGame>
     inline void MonteCarloGraphSearch<TGame>::backup_dv(const vector<State*>& origins, Timeline tl) {
 
@@ -249,16 +459,13 @@ namespace Maestro {
             State* cur = _backup_stack.back();
             _backup_stack.pop_back();
             ++visit_expect;
-            for (auto& wpa : cur->parent_actions) {
-                if (shared_ptr<Action> pa = wpa.lock(); pa) {
-                    shared_ptr<State> ps = pa->parent_state.lock();
-                    assert(ps);
-                    int child_before = ps->backup_total_child_count(ts);
-                    if (child_before == 0) {
-                        _backup_stack.push_back(ps.get());
-                    }
-                    ++ps->backup_total_child_count(ts);
+            for (NodeId pa_id : cur->parent_actions) {
+                State* ps = &_states[_actions[pa_id].parent_state];
+                int child_before = ps->backup_total_child_count(ts);
+                if (child_before == 0) {
+                    _backup_stack.push_back(ps);
                 }
+                ++ps->backup_total_child_count(ts);
             }
         }
 
@@ -274,23 +481,29 @@ namespace Maestro {
 
             float cur_v_before = cur->v;
             // ۼdvv
-            cur->v += cur->dv(ts);
+            cur->v = cur_v_before + cur->dv(ts);
             float cur_v_after = cur->v;
 
-            for (auto& wpa : cur->parent_actions) {
-                shared_ptr<Action> pa = wpa.lock();
-                if (pa) {
-                    shared_ptr<State> ps = pa->parent_state.lock();
-                    assert(ps);
-                    Color cur_color = cur->game.get_color();
+            for (NodeId pa_id : cur->parent_actions) {
+                Action* pa = &_actions[pa_id];
+                State* ps = &_states[pa->parent_state];
+                Color cur_color = cur->game.get_color();
+                float q = ps->convert_v(cur_color, cur_v_after);
+                int visit;
+                {
+                    SpinLockGuard guard(ps->lock);
+                    int slot;
+                    EdgeLane& lane = edge_lane(pa, slot);
+                    lane.q[slot] = q;
+                    visit = lane.visit[slot];
+                }
 
-                    // ״̬dvǰdvۼ
-                    ps->dv(ts) += (ps->convert_v(cur_color, cur_v_after) - ps->convert_v(cur_color, cur_v_before)) * pa->visit / ps->ns;
+                // ״̬dvǰdvۼ
+                ps->dv(ts) += (q - ps->convert_v(cur_color, cur_v_before)) * visit / ps->ns;
 
-                    ps->backup_visited_child_count(ts)++;
-                    if (ps->backup_visited_child_count(ts) == ps->backup_total_child_count(ts)) {
-                        _backup_stack.push_back(ps.get());
-                    }
+                ps->backup_visited_child_count(ts)++;
+                if (ps->backup_visited_child_count(ts) == ps->backup_total_child_count(ts)) {
+                    _backup_stack.push_back(ps);
                 }
             }
         }
@@ -302,7 +515,7 @@ namespace Maestro {
     inline void MonteCarloGraphSearch<TGame>::slow_dfs_traversal(function<void(State*)> fn) {
         vector<State*> stack;
         unordered_set<State*> visited;
-        stack.push_back(_root.get());
+        stack.push_back(&_states[_root]);
         while (!stack.empty()) {
             State* current = stack.back();
             stack.pop_back();
@@ -310,14 +523,13 @@ namespace Maestro {
             visited.insert(current);
             fn(current);
 
-            if (current->child_actions.initialized()) {
-                for (auto& ac : current->child_actions.value()) {
-                    if (ac->child_state.initialized()) {
-                        State* ptr = ac->child_state.value().get();
-                        // not visited
-                        if (visited.find(ptr) == visited.end()) {
-                            stack.push_back(ptr);
-                        }
+            for (int i = 0; i < current->n_actions; i++) {
+                Action* ac = &_actions[current->first_action + i];
+                if (ac->child_state != NULL_NODE) {
+                    State* ptr = &_states[ac->child_state];
+                    // not visited
+                    if (visited.find(ptr) == visited.end()) {
+                        stack.push_back(ptr);
                     }
                 }
             }
@@ -342,75 +554,178 @@ namespace Maestro {
 
     template<typename TGame>
     inline void MonteCarloGraphSearch<TGame>::generate_root_dirichlet_noise() {
-        if (_root->noise_generated) return;
-        _root->noise_generated = true;
-        auto all_moves = _root->game.get_all_legal_moves();
-        auto noise = rand_dirichlet(all_moves.size(), 0.03);
-
+        State* root = &_states[_root];
+        if (root->noise_generated) return;
+        root->noise_generated = true;
+        int n_legal = LegalMoves<TGame>::count(root->game);
+        auto noise = rand_dirichlet(n_legal, 0.03);
+
+        // moves without a prior get an action too, so the root's block is
+        // reallocated to hold every legal move
+        Action* old_actions = child_actions(root);
+        int n_old = root->n_actions;
+        // slot of the i-th legal move
+        vector<int> old_index(n_legal, -1);
+        int n_missing = 0;
         int i = 0;
-        for (auto& m : all_moves) {
-            bool found = false;
-            Action* action = nullptr;
-            for (auto& ac : _root->child_actions.value()) {
-                if (ac->move == m) {
-                    found = true;
-                    action = ac.get();
+        LegalMoves<TGame>::for_each(root->game, [&](Move<TGame> m) {
+            for (int j = 0; j < n_old; j++) {
+                if (old_actions[j].move == m) {
+                    old_index[i] = j;
                     break;
                 }
             }
-            if (!found) {
-                auto ac = create_action(m, weak_ptr(_root), 0);
-                action = ac.get();
-                _root->child_actions->push_back(ac);
+            if (old_index[i++] < 0) n_missing++;
+        });
+
+        if (n_missing > 0) {
+            int n = n_old + n_missing;
+            NodeId first = _actions.alloc(n);
+            NodeId first_lane = _lanes.alloc(edge_lane_count(n));
+            Action* actions = &_actions[first];
+            EdgeLane* lanes = &_lanes[first_lane];
+            if (n_old > 0) {
+                copy(edge_lanes(root), edge_lanes(root) + edge_lane_count(n_old), lanes);
+            }
+            for (int j = 0; j < n_old; j++) {
+                Action& ac = actions[j];
+                ac.id = first + j;
+                ac.move = old_actions[j].move;
+                ac.parent_state = root->id;
+                ac.child_state = old_actions[j].child_state;
+                if (ac.child_state != NULL_NODE) {
+                    for (NodeId& pa : _states[ac.child_state].parent_actions) {
+                        if (pa == old_actions[j].id) pa = ac.id;
+                    }
+                }
             }
-            action->p_noise_delta = -NOISE_EPSILON * action->p + NOISE_EPSILON * noise[i];
-            ++i;
+            int k = n_old;
+            i = 0;
+            LegalMoves<TGame>::for_each(root->game, [&](Move<TGame> m) {
+                if (old_index[i] < 0) {
+                    Action& ac = actions[k];
+                    ac.id = first + k;
+                    ac.move = m;
+                    ac.parent_state = root->id;
+                    // the copied padding of the old last lane becomes a real slot
+                    lanes[k >> 3].p[k & 7] = 0;
+                    lanes[k >> 3].q[k & 7] = 0;
+                    old_index[i] = k++;
+                }
+                i++;
+            });
+            pad_edge_lanes(lanes, n);
+            root->first_action = first;
+            root->first_lane = first_lane;
+            root->n_actions = n;
+        }
+
+        EdgeLane* lanes = edge_lanes(root);
+        for (i = 0; i < n_legal; i++) {
+            float& p = lanes[old_index[i] >> 3].p[old_index[i] & 7];
+            p += -NOISE_EPSILON * p + NOISE_EPSILON * noise[i];
         }
     }
 
     template<typename TGame>
-    inline void MonteCarloGraphSearch<TGame>::simulate(int k) {
+    inline int MonteCarloGraphSearch<TGame>::simulate(int k) {
         // global_stat = GlobalStat();
+        auto start = chrono::steady_clock::now();
+        int sims_before = global_stat.sim_total;
 
-        int cur_leaf_batch_count = 0;
-        vector<State*> eval_batch;
+        State* root = &_states[_root];
 
-        int ts_last_batch = 0;
+        // ڵҪ⴦
+        if (k > 0 && !root->evaluated) {
+            global_stat.sim_total++;
+            root->ns++;
+            root->eval = make_unique<Evaluation<TGame>>(evaluate_single(root->game));
+            root->v = root->eval->v;
+            root->evaluated = true;
+            --k;
+        }
 
-        for (int i_sim = 1; i_sim <= k; i_sim++) {
-            bool evaluating_node_visited = false;
+        if (_config.dirichlet_noise && root->evaluated) {
+            generate_root_dirichlet_noise();
+        }
 
-            global_stat.sim_total++;
-            _timeline.next_epoch();
-            _sim_stack.clear();
+        // a full bucket evicts the entries last inserted or found in the
+        // earliest call first; move() re-inserts the reachable states
+        _transposition.next_generation();
+
+        int n_threads = max(1, _config.n_threads);
+        _workers.resize(n_threads);
+        atomic<int> sims_left(k);
+        double busy_before = _evaluator->busy_seconds();
 
-            _root->ns++;
-            // ڵҪ⴦
-            if (!_root->evaluated) {
-                _root->eval = make_unique<Evaluation<TGame>>(_evaluator->evaluate(_root->game));
-                _root->evaluated = true;
-                _root->v = _root->eval->v;
-                continue;
+        if (n_threads == 1) {
+            run_worker(_workers[0], sims_left);
+        }
+        else {
+            vector<thread> threads;
+            vector<exception_ptr> errors(n_threads);
+            for (int i = 0; i < n_threads; i++) {
+                threads.emplace_back([this, i, &sims_left, &errors]() {
+                    try {
+                        run_worker(_workers[i], sims_left);
+                    }
+                    catch (...) {
+                        errors[i] = current_exception();
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+            for (auto& e : errors) {
+                if (e) rethrow_exception(e);
             }
+        }
+
+        double sync_busy = 0;
+        for (auto& w : _workers) {
+            sync_busy += w.stat.eval_busy_seconds;
+            w.stat.eval_busy_seconds = 0;
+            global_stat.merge(w.stat);
+            w.stat = GlobalStat();
+        }
+        // evaluators that do not track their time only run inside the workers' calls
+        global_stat.eval_busy_seconds += busy_before >= 0 ? _evaluator->busy_seconds() - busy_before : sync_busy / n_threads;
+        global_stat.n_threads = n_threads;
+        global_stat.sim_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-            if (_config.dirichlet_noise) {
-                generate_root_dirichlet_noise();
+        global_stat.tt_load_factor = _transposition.load_factor();
+        global_stat.tt_replaced = _transposition.replaced();
+        update_mem_stat();
+        return global_stat.sim_total - sims_before;
+    }
+
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::run_worker(Worker& w, atomic<int>& sims_left) {
+        while (!this->_stop.load(memory_order_relaxed) && claim_simulation(sims_left)) {
+            bool evaluating_node_visited = false;
+            if (!w.in_flight.empty()) {
+                collect_batches(w, false);
             }
 
-            State* current = _root.get();
+            w.stat.sim_total++;
+            w.sim_stack.clear();
+            w.path.clear();
+
+            State* current = &_states[_root];
+            current->ns++;
 
             float backup_v = 0;
             bool use_transposition = false;
 
             while (true) {
-                _sim_stack.push_back(current);
-                ++current->virtual_loss_cnt(ts_last_batch);
+                w.sim_stack.push_back(current);
 
                 auto& game = current->game;
                 Status stat = game.get_status();
 
                 if (stat.end) {
-                    global_stat.sim_game_end++;
+                    w.stat.sim_game_end++;
                     if (stat.winner == game.get_color()) {
                         backup_v = 1;
                     }
@@ -424,7 +739,7 @@ namespace Maestro {
                 }
 
                 if (use_transposition) {
-                    global_stat.sim_use_transposition++;
+                    w.stat.sim_use_transposition++;
                     backup_v = current->v;
                     break;
                 }
@@ -436,153 +751,464 @@ namespace Maestro {
 
                 if (!current->evaluated) {
                     if (current->evaluating) {
-                        global_stat.visit_evaluating++;
+                        // nothing to back up until its batch is applied
+                        w.stat.visit_evaluating++;
                         evaluating_node_visited = true;
-                        backup_v = 0;
                         break;
                     }
-                    else {
+                    // evaluated is set before evaluating is cleared, so re-check
+                    // in case the batch was applied by another thread meanwhile
+                    else if (!current->evaluated) {
                         throw logic_error("?");
                         assert(0);
                     }
                 }
 
-                vector<shared_ptr<Action>>& actions = current->child_actions.value();
-
-                vector<float> ac_ucb_temp;
-                ac_ucb_temp.reserve(actions.size());
                 Action* action = nullptr;
-                int max_idx = -1;
-                float max_ucb = -100000;
-                int idx = 0;
-                for (auto& ac : actions) {
-                    float ucb = action_ucb(current, ac.get(), ts_last_batch);
-                    ac_ucb_temp.push_back(ucb);
-                    if (ucb >= max_ucb) {
-                        max_ucb = ucb;
-                        max_idx = idx;
-                        action = ac.get();
-                    }
-                    idx++;
-                }
-
-                ac_ucb_temp[max_idx] += 1000; // Ҫ֤ѡеactionǰ
-
-                if (!action->child_state.initialized() && action->child_state.value().get()->ns == 0) {
-                    // ǰkδʼӽڵ
-                    // ֵУΪevaluating
-                    vector<int> ac_no;
-                    ac_no.reserve(actions.size());
-                    for (int i = 0; i < actions.size(); i++) {
-                        ac_no.push_back(i);
-                    }
-
-                    // TODO: öŻ
-                    sort(ac_no.begin(), ac_no.end(), [&ac_ucb_temp](int no1, int no2) { return ac_ucb_temp[no1] > ac_ucb_temp[no2]; });
+                State* next = nullptr;
+                int visit;
+                {
+                    SpinLockGuard guard(current->lock);
+                    Action* actions = child_actions(current);
+                    int n_actions = current->n_actions;
+                    EdgeLane* lanes = edge_lanes(current);
+                    float c = _config.puct * sqrtf(current->ns.load(memory_order_relaxed));
+
+                    int max_idx = puct_argmax(lanes, n_actions, c, _config.virtual_loss);
+                    action = &actions[max_idx];
+
+                    if (action->child_state == NULL_NODE && child_state(action, w)->ns == 0) {
+                        // ǰkδʼӽڵ
+                        // ֵУΪevaluating
+                        w.scores.resize(n_actions);
+                        puct_scores(lanes, n_actions, c, _config.virtual_loss, w.scores.data());
+                        w.scores[max_idx] += 1000; // Ҫ֤ѡеactionǰ
+
+                        w.order.resize(n_actions);
+                        for (int i = 0; i < n_actions; i++) {
+                            w.order[i] = i;
+                        }
 
-                    int cur_cnt = 0;
-                    int t = 0;
-                    for (int no : ac_no) {
-                        if (actions[no]->child_state.initialized()) {
-                            State* cs = actions[no]->child_state.value().get();
-                            if (cs->ns > 0) {
-                                t++;
+                        // TODO: öŻ
+                        auto& scores = w.scores;
+                        sort(w.order.begin(), w.order.end(), [&scores](int no1, int no2) { return scores[no1] > scores[no2]; });
+
+                        int cur_cnt = 0;
+                        int t = 0;
+                        for (int no : w.order) {
+                            if (actions[no].child_state != NULL_NODE) {
+                                State* cs = &_states[actions[no].child_state];
+                                if (cs->ns > 0) {
+                                    t++;
+                                }
                             }
                         }
-                    }
-
-                    int target_cnt = clamp(t * 1, 1, 20000);
-
-                    for (int no : ac_no) {
-                        State* cs = actions[no]->child_state.value().get();
-                        if (cs->ns == 0) {
-                            if (!cs->game.get_status().end && !cs->evaluating && !cs->evaluated) {
 
-                                cur_cnt++;
-                                cs->stop_selection = true;
-                                cs->evaluating = true;
-                                eval_batch.push_back(cs);
+                        int target_cnt = clamp(t * 1, 1, 20000);
+
+                        for (int no : w.order) {
+                            State* cs = child_state(&actions[no], w);
+                            if (cs->ns == 0) {
+                                bool not_evaluating = false;
+                                // a state reachable from several parents may be claimed by another
+                                // thread; claim it first, then re-check evaluated, which
+                                // set_evaluations sets before it clears evaluating
+                                if (!cs->game.get_status().end && !cs->evaluated &&
+                                    cs->evaluating.compare_exchange_strong(not_evaluating, true)) {
+                                    if (cs->evaluated) {
+                                        cs->evaluating = false;
+                                        continue;
+                                    }
+
+                                    _leaves_pending++;
+                                    cur_cnt++;
+                                    cs->stop_selection = true;
+                                    w.eval_batch.push_back(cs);
+                                }
                             }
+                            if (cur_cnt >= target_cnt) break;
                         }
-                        if (cur_cnt >= target_cnt) break;
+
+                        w.leaf_batch_count++;
                     }
 
-                    cur_leaf_batch_count++;
+                    next = child_state(action, w);
+
+                    EdgeLane& lane = lanes[max_idx >> 3];
+                    visit = ++lane.visit[max_idx & 7];
+                    ++lane.vl[max_idx & 7];
+                    w.vl_applied.push_back(action);
                 }
 
-                State* next = action->child_state.value().get();
-                int ns_before = next->ns;
-                action->visit++;
-                int ns_after = next->ns = max(next->ns, action->visit);
+                int ns_before = next->ns.load();
+                while (ns_before < visit && !next->ns.compare_exchange_weak(ns_before, visit)) {}
+                w.path.push_back({ action, visit, ns_before < visit });
 
-                if (ns_before == ns_after) {
+                if (visit <= ns_before) {
                     use_transposition = true;
                 }
 
                 current = next;
             }
 
-            State* leaf = _sim_stack.back();
-            if (leaf->stop_selection) global_stat.node_evaluated_used++;
-            leaf->stop_selection = false;
-            leaf->dv(_timeline.time()) += (backup_v - leaf->v) / leaf->ns;
-
-            // ·ϵvns+1
-            for (int i = 0; i < _sim_stack.size() - 1; i++) {
-                State* cur = _sim_stack[i];
-                State* next = _sim_stack[i + 1];
-                cur->dv(_timeline.time()) += (cur->convert_v(next) - cur->v) / cur->ns;
+            if (evaluating_node_visited) {
+                // the simulation reached a leaf another batch is evaluating:
+                // take its visits back and leave it to a later one
+                abandon(w);
+                sims_left++;
+                w.stat.sim_total--;
             }
+            else {
+                lock_guard<mutex> guard(_backup_mutex);
+                for (Action* ac : w.new_links) {
+                    link_child(ac);
+                }
+                w.new_links.clear();
+                _timeline.next_epoch();
+
+                State* leaf = w.sim_stack.back();
+                if (leaf->stop_selection) w.stat.node_evaluated_used++;
+                leaf->stop_selection = false;
+                leaf->dv(_timeline.time()) += (backup_v - leaf->v) / leaf->ns;
+
+                // ·ϵvns+1
+                for (int i = 0; i < int(w.sim_stack.size()) - 1; i++) {
+                    State* cur = w.sim_stack[i];
+                    State* next = w.sim_stack[i + 1];
+                    cur->dv(_timeline.time()) += (cur->convert_v(next) - cur->v) / cur->ns;
+                }
 
-            vector<State*> ls;
-            ls.push_back(leaf);
-            backup_dv(ls);
+                vector<State*> ls;
+                ls.push_back(leaf);
+                backup_dv(ls);
+            }
 
-            if (evaluating_node_visited || cur_leaf_batch_count == _config.leaf_batch_count || i_sim == k) {
-                if (eval_batch.size() > 0) {
-                    global_stat.eval_batch_count++;
-                    global_stat.node_evaluated_total += eval_batch.size();
-                    vector<TGame*> games;
-                    for (State* s : eval_batch) {
-                        games.push_back(&s->game);
+            if (evaluating_node_visited || w.leaf_batch_count == _config.leaf_batch_count) {
+                // with nothing new to send, wait for a batch in flight rather
+                // than descend into the same pending leaves again
+                bool stalled = evaluating_node_visited && w.eval_batch.empty();
+                flush_batch(w);
+                if (stalled) {
+                    if (!w.in_flight.empty()) {
+                        collect_batches(w, true);
                     }
-                    vector<Evaluation<TGame>> evals = _evaluator->evaluate(games);
-                    assert(evals.size() == eval_batch.size());
-                    for (int i = 0; i < evals.size(); i++) {
-                        State* s = eval_batch[i];
-                        s->evaluated = true;
-                        s->evaluating = false;
-                        s->eval = make_unique<Evaluation<TGame>>(std::move(evals[i]));
-                        assert(s->v == 0.0f);
-                        s->dv(_timeline.time(Timeline::backup_eval)) = s->eval->v;
+                    else {
+                        wait_other_batches(w);
                     }
+                }
+            }
+        }
+
+        flush_batch(w);
+        while (!w.in_flight.empty()) {
+            collect_batches(w, true);
+        }
+    }
 
-                    backup_dv(eval_batch, Timeline::backup_eval);
+    // Sends the collected leaves to the evaluator. Virtual losses applied
+    // since the previous call stay in place until the batch is applied.
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::flush_batch(Worker& w) {
+        if (_config.eval_cache && w.eval_batch.size() > 0) {
+            apply_cached(w);
+        }
+        if (w.eval_batch.size() > 0) {
+            w.stat.eval_batch_count++;
+            w.stat.node_evaluated_total += w.eval_batch.size();
+            auto start = chrono::steady_clock::now();
+
+            if (_config.eval_queue_depth <= 0) {
+                vector<TGame*> games;
+                for (State* s : w.eval_batch) {
+                    games.push_back(&s->game);
+                }
+                vector<Evaluation<TGame>> evals = _evaluator->evaluate(games);
+                double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                w.stat.eval_wait_seconds += t;
+                w.stat.eval_busy_seconds += t;
+                apply_batch(w.eval_batch, evals, w.vl_applied);
+            }
+            else {
+                vector<TGame> games;
+                for (State* s : w.eval_batch) {
+                    games.push_back(s->game);
                 }
-                eval_batch.clear();
-                cur_leaf_batch_count = 0;
-                ts_last_batch = _timeline.time();
+                typename Worker::Batch batch;
+                batch.evals = _evaluator->evaluate_async(std::move(games));
+                // evaluators without a pool have finished by now
+                w.stat.eval_busy_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                batch.states.swap(w.eval_batch);
+                batch.vl_applied.swap(w.vl_applied);
+                w.in_flight.push_back(std::move(batch));
+                while (int(w.in_flight.size()) > _config.eval_queue_depth) {
+                    collect_batches(w, true);
+                }
+                w.stat.eval_max_in_flight = max(w.stat.eval_max_in_flight, int(w.in_flight.size()));
             }
         }
+        w.eval_batch.clear();
+        w.leaf_batch_count = 0;
 
-        global_stat.tt_load_factor = _transposition.load_factor();
+        for (Action* ac : w.vl_applied) {
+            SpinLockGuard guard(_states[ac->parent_state].lock);
+            int slot;
+            --edge_lane(ac, slot).vl[slot];
+        }
+        w.vl_applied.clear();
     }
 
+    // Applies the finished batches at the front of w.in_flight; with wait
+    // set, first blocks until the oldest one is done.
     template<typename TGame>
-    inline void MonteCarloGraphSearch<TGame>::move(Move<TGame> move) {
-        TGame g = _root->game;
-        g.move(move);
-        _root = create_state(g, true);
+    inline void MonteCarloGraphSearch<TGame>::collect_batches(Worker& w, bool wait) {
+        while (!w.in_flight.empty()) {
+            auto& batch = w.in_flight.front();
+            if (wait) {
+                auto start = chrono::steady_clock::now();
+                batch.evals.wait();
+                w.stat.eval_wait_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                wait = false;
+            }
+            else if (batch.evals.wait_for(chrono::seconds(0)) != future_status::ready) {
+                break;
+            }
 
-        for (auto it = begin(_transposition); it != end(_transposition);)
+            vector<Evaluation<TGame>> evals = batch.evals.get();
+            apply_batch(batch.states, evals, batch.vl_applied);
+            w.in_flight.pop_front();
+        }
+    }
+
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::apply_batch(const vector<State*>& states, vector<Evaluation<TGame>>& evals, vector<Action*>& vl_applied) {
+        assert(evals.size() == states.size());
+        if (_config.eval_cache) {
+            for (int i = 0; i < int(evals.size()); i++) {
+                _config.eval_cache->insert(states[i]->game, evals[i]);
+            }
+        }
         {
-            if (!_root->game.could_transfer_to(it->first))
-            {
-                it = _transposition.erase(it);
+            lock_guard<mutex> guard(_backup_mutex);
+            set_evaluations(states, evals);
+        }
+        _batch_applied.notify_all();
+
+        for (Action* ac : vl_applied) {
+            SpinLockGuard guard(_states[ac->parent_state].lock);
+            int slot;
+            --edge_lane(ac, slot).vl[slot];
+        }
+        vl_applied.clear();
+    }
+
+    // Takes the leaves of w.eval_batch found in the evaluation cache out of
+    // the batch and applies their evaluations right away.
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::apply_cached(Worker& w) {
+        vector<State*> states;
+        vector<Evaluation<TGame>> evals;
+        Evaluation<TGame> eval;
+        int n_missed = 0;
+        for (State* s : w.eval_batch) {
+            if (_config.eval_cache->find(s->game, eval)) {
+                states.push_back(s);
+                evals.push_back(std::move(eval));
             }
             else {
-                ++it;
+                w.eval_batch[n_missed++] = s;
             }
         }
+        w.stat.eval_cache_lookups += int(w.eval_batch.size());
+        w.stat.eval_cache_hits += int(states.size());
+        w.eval_batch.resize(n_missed);
+        if (states.empty()) return;
+
+        {
+            lock_guard<mutex> guard(_backup_mutex);
+            set_evaluations(states, evals);
+        }
+        _batch_applied.notify_all();
+    }
+
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::set_evaluations(const vector<State*>& states, vector<Evaluation<TGame>>& evals) {
+        _timeline.next_epoch();
+        for (int i = 0; i < int(evals.size()); i++) {
+            State* s = states[i];
+            assert(s->v == 0.0f);
+            s->dv(_timeline.time(Timeline::backup_eval)) = evals[i].v;
+            // once evaluated is set another worker may consume eval
+            s->eval = make_unique<Evaluation<TGame>>(std::move(evals[i]));
+            s->evaluated = true;
+            s->evaluating = false;
+        }
+        _leaves_pending -= int(states.size());
+
+        backup_dv(states, Timeline::backup_eval);
+        _batches_applied++;
+    }
+
+    // Evaluates a single position, through the evaluation cache if any.
+    template<typename TGame>
+    inline Evaluation<TGame> MonteCarloGraphSearch<TGame>::evaluate_single(const TGame& game) {
+        Evaluation<TGame> eval;
+        if (_config.eval_cache) {
+            global_stat.eval_cache_lookups++;
+            if (_config.eval_cache->find(game, eval)) {
+                global_stat.eval_cache_hits++;
+                return eval;
+            }
+        }
+        eval = _evaluator->evaluate(game);
+        if (_config.eval_cache) {
+            _config.eval_cache->insert(game, eval);
+        }
+        return eval;
+    }
+
+    // Takes back the visits of a simulation that ends without a value. Its
+    // virtual losses stay until the next batch is sent, as for the others.
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::abandon(Worker& w) {
+        for (int i = int(w.path.size()) - 1; i >= 0; i--) {
+            auto& step = w.path[i];
+            {
+                SpinLockGuard guard(_states[step.action->parent_state].lock);
+                int slot;
+                --edge_lane(step.action, slot).visit[slot];
+            }
+            if (step.raised) {
+                int expected = step.visit;
+                w.sim_stack[i + 1]->ns.compare_exchange_strong(expected, step.visit - 1);
+            }
+        }
+        w.sim_stack[0]->ns--;
+        if (!w.new_links.empty()) {
+            lock_guard<mutex> guard(_backup_mutex);
+            for (Action* ac : w.new_links) {
+                link_child(ac);
+            }
+            w.new_links.clear();
+        }
+    }
+
+    // Blocks until another worker applies a batch, for a worker whose
+    // simulations only reach leaves that others are evaluating. Leaves may
+    // still wait in another worker's unsent batch, which that worker sends
+    // at the latest when its simulations run out.
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::wait_other_batches(Worker& w) {
+        auto start = chrono::steady_clock::now();
+        unique_lock<mutex> lock(_backup_mutex);
+        int seen = _batches_applied;
+        _batch_applied.wait(lock, [this, seen]() { return _batches_applied != seen || _leaves_pending == 0; });
+        w.stat.eval_wait_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::move(Move<TGame> move) {
+        auto start = chrono::steady_clock::now();
+        TGame g = _states[_root].game;
+        g.move(move);
+        NodeId new_root = create_state(g, true);
+        size_t n_before = _states.size();
+        compact(new_root);
+        update_mem_stat();
+
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        global_stat.gc_moves++;
+        global_stat.gc_kept = _states.size();
+        global_stat.gc_dropped = n_before - _states.size();
+        global_stat.gc_seconds += t;
+        global_stat.gc_max_seconds = max(global_stat.gc_max_seconds, t);
+    }
+
+    // Copies the graph reachable from new_root into fresh arenas, then drops
+    // the old arenas in bulk, on the reclaimer thread with background_free.
+    // Parent links from unreachable states vanish with them. The
+    // transposition table is expired and refilled with the survivors, so
+    // the whole move costs time in the reachable part only.
+    template<typename TGame>
+    inline void MonteCarloGraphSearch<TGame>::compact(NodeId new_root) {
+        NodeArena<State> states;
+        NodeArena<Action> actions;
+        NodeArena<EdgeLane, 10> lanes;
+        vector<NodeId> queue;
+
+        auto copy_state = [&](NodeId old_id) {
+            State& s = _states[old_id];
+            if (s.forward == NULL_NODE) {
+                NodeId id = states.alloc();
+                State& t = states[id];
+                t.id = id;
+                t.stop_selection = s.stop_selection.load();
+                t.evaluated = s.evaluated.load();
+                t.eval = std::move(s.eval);
+                t.game = s.game;
+                t.ns = s.ns.load();
+                t.v = s.v.load();
+                t.dv = s.dv;
+                t.noise_generated = s.noise_generated;
+                t.evaluating = s.evaluating.load();
+                t.backup_visited_child_count = s.backup_visited_child_count;
+                t.backup_total_child_count = s.backup_total_child_count;
+                s.forward = id;
+                queue.push_back(old_id);
+            }
+            return s.forward;
+        };
+
+        NodeId root = copy_state(new_root);
+        for (size_t i = 0; i < queue.size(); i++) {
+            State& s = _states[queue[i]];
+            if (s.n_actions == 0) continue;
+
+            NodeId first = actions.alloc(s.n_actions);
+            NodeId first_lane = lanes.alloc(edge_lane_count(s.n_actions));
+            NodeId parent = s.forward;
+            states[parent].first_action = first;
+            states[parent].first_lane = first_lane;
+            states[parent].n_actions = s.n_actions;
+            copy(edge_lanes(&s), edge_lanes(&s) + edge_lane_count(s.n_actions), &lanes[first_lane]);
+            for (int k = 0; k < s.n_actions; k++) {
+                Action& a = _actions[s.first_action + k];
+                Action& b = actions[first + k];
+                b.id = first + k;
+                b.move = a.move;
+                b.parent_state = parent;
+                if (a.child_state != NULL_NODE) {
+                    b.child_state = copy_state(a.child_state);
+                    states[b.child_state].parent_actions.push_back(b.id);
+                }
+            }
+        }
+
+        _states.swap(states);
+        _actions.swap(actions);
+        _lanes.swap(lanes);
+        _root = root;
+
+        _transposition.expire();
+        for (NodeId old_id : queue) {
+            NodeId id = states[old_id].forward;
+            const TGame& game = _states[id].game;
+            _transposition.find_or_insert(game.get_hash(),
+                [this, &game](NodeId other) { return _states[other].game == game; },
+                [id]() { return id; });
+        }
+
+        if (_config.background_free) {
+            struct Garbage {
+                NodeArena<State> states;
+                NodeArena<Action> actions;
+                NodeArena<EdgeLane, 10> lanes;
+            };
+            auto garbage = make_unique<Garbage>();
+            garbage->states.swap(states);
+            garbage->actions.swap(actions);
+            garbage->lanes.swap(lanes);
+            if (_reclaimer.joinable()) _reclaimer.join();
+            _reclaimer = thread([garbage = std::move(garbage)]() mutable { garbage.reset(); });
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <maestro/search/search_base.h>
+#include <maestro/evaluator/eval_cache.h>
+#include <stdexcept>
 
 namespace Maestro {
 	template<typename TGame>
@@ -10,6 +12,7 @@ namespace Maestro {
 			m_move = m;
 			m_game = g;
 			m_N = m_Q = m_W = 0;
+			m_VL = 0;
 		}
 
 		~MCTSNode() {
@@ -18,13 +21,15 @@ namespace Maestro {
 					delete child;
 				}
 			}
+			// nullptr once expanded
+			delete m_game;
 		}
 
-		MCTSNode* select_best(float kucb) {
+		MCTSNode* select_best(float kucb, float virtual_loss) {
 			MCTSNode* ret = nullptr;
 			float max;
 			for (MCTSNode<TGame>*& child : m_children) {
-				float ucb = child->cal_UCB(kucb);
+				float ucb = child->cal_UCB(kucb, virtual_loss);
 				if (ret == nullptr) {
 					max = ucb;
 					ret = child;
@@ -36,12 +41,12 @@ namespace Maestro {
 			return ret;
 		}
 
-		MCTSNode* select_best_with_diri(float kucb, const vector<float>& noise) {
+		MCTSNode* select_best_with_diri(float kucb, float virtual_loss, const vector<float>& noise) {
 			MCTSNode* ret = nullptr;
 			float max;
 			for (int i = 0; i < m_children.size(); ++i) {
                 // : epsilon
-				float ucb = m_children[i]->cal_UCB(kucb, noise[i], 0.25);
+				float ucb = m_children[i]->cal_UCB(kucb, virtual_loss, noise[i], 0.25);
 				if (ret == nullptr) {
 					max = ucb;
 					ret = m_children[i];
@@ -57,7 +62,7 @@ namespace Maestro {
 			if (!expanded()) {
 				Status s = m_game->get_status();
 				if (s.end) {
-					backup(m_game->get_color() != s.winner ? 1 : -1);
+					backup(s.winner == Color::None ? 0 : s.winner == m_game->get_color() ? 1 : -1);
 				} else {
 					backup(eval.v);
 					for (MovePrior<TGame>& p : eval.p) {
@@ -71,18 +76,28 @@ namespace Maestro {
 			}
 		}
 
-		inline float cal_UCB(float k, float eta = 0, float epsilon = 0) {
-			return m_Q + ((1 - epsilon) * m_move.p + epsilon * eta) 
-				* k * sqrt(m_parent->m_N) / (1 + m_N);
+		// m_Q is for the player to move here, the parent picks for the other one;
+		// pending evaluations below count as losses for the parent
+		inline float cal_UCB(float k, float virtual_loss, float eta = 0, float epsilon = 0) {
+			int n = m_N + m_VL;
+			float q = n > 0 ? (-m_W - m_VL * virtual_loss) / n : 0;
+			return q + ((1 - epsilon) * m_move.p + epsilon * eta)
+				* k * sqrt(m_parent->m_N) / (1 + n);
 		}
 
 		inline bool expanded() {
 			return m_game == nullptr;
 		}
 
+		// adds d pending evaluations to this node and its ancestors
+		void add_virtual_loss(int d) {
+			for (MCTSNode* pcur = this; pcur != nullptr; pcur = pcur->m_parent) {
+				pcur->m_VL += d;
+			}
+		}
+
 		void backup(float v) {
-			MCTSNode* pcur = m_parent;
-			v = -v;
+			MCTSNode* pcur = this;
 			while (pcur != nullptr) {
 				pcur->m_N++;
 				pcur->m_W += v;
@@ -99,37 +114,79 @@ namespace Maestro {
 		int m_N;									// visit cnt
 		float m_Q;									// action value Q
 		float m_W;									// sum of V in subtree, used in calculating Q
+		int m_VL;									// evaluations pending in subtree
 	};
 
 	template<typename TGame>
 	class MonteCarloTreeSearch final : public IMonteCarloSearch<TGame> {
 	public:
         // : kucb
-		MonteCarloTreeSearch(TGame* init, float kucb, IEvaluator<TGame>* evaluator) {
-			m_root = new MCTSNode<TGame>(nullptr, MovePrior<TGame>(), init);
+        // cache: looked up before evaluating a leaf, may be shared with other searches
+        // leaf_batch_count: leaves gathered under virtual loss and evaluated in one batch
+		MonteCarloTreeSearch(TGame* init, float kucb, IEvaluator<TGame>* evaluator,
+			shared_ptr<EvaluationCache<TGame>> cache = nullptr,
+			int leaf_batch_count = 1, float virtual_loss = 1) {
+			m_root = new MCTSNode<TGame>(nullptr, MovePrior<TGame>(), new TGame(*init));
 			m_root_game = TGame(*init);
 			m_kucb = kucb;
 			m_evaluator = evaluator;
+			m_cache = std::move(cache);
+			m_leaf_batch_count = max(1, leaf_batch_count);
+			m_virtual_loss = virtual_loss;
             
-            m_root->expand(m_evaluator->evaluate(m_root_game));
+            m_root->expand(evaluate(m_root_game));
             root_expand2();
 		}
 
+		~MonteCarloTreeSearch() {
+			delete m_root;
+		}
+
+		MonteCarloTreeSearch(const MonteCarloTreeSearch&) = delete;
+		MonteCarloTreeSearch& operator=(const MonteCarloTreeSearch&) = delete;
+
         // : kε
-		void simulate(int k) {
-			for (int i = 0; i < k; ++i) {
-				MCTSNode<TGame>* pcur = m_root;
-				while (!pcur->m_game->get_status().end) {
-					if (!pcur->expanded()) {
-						pcur->expand(m_evaluator->evaluate(*pcur->m_game));
+        // A simulation is one descent from the root to a leaf. Descents
+        // gather leaves until leaf_batch_count are pending or one reaches a
+        // pending leaf, then the leaves are evaluated in one batch.
+		int simulate(int k) {
+			int i = 0;
+			vector<MCTSNode<TGame>*> leaves;
+			while (i < k && !this->_stop) {
+				leaves.clear();
+				int n = min(m_leaf_batch_count, k - i);
+				for (int j = 0; j < n; ++j) {
+					MCTSNode<TGame>* pcur = m_root;
+					while (pcur->expanded() && !pcur->m_children.empty()) {
+                        if (pcur == m_root) {
+                            pcur = pcur->select_best_with_diri(m_kucb, m_virtual_loss, m_noise);
+                        } else {
+						    pcur = pcur->select_best(m_kucb, m_virtual_loss);
+                        }
+					}
+					if (pcur->m_VL > 0) {
+						// waiting for its evaluation
+						break;
+					}
+					++i;
+					if (pcur->expanded()) {
+						// game end, its value never changes
+						pcur->backup(pcur->m_Q);
+					} else if (pcur->m_game->get_status().end) {
+						pcur->expand(Evaluation<TGame>());
+					} else {
+						pcur->add_virtual_loss(1);
+						leaves.push_back(pcur);
 					}
-                    if (pcur == m_root) {
-                        pcur = pcur->select_best_with_diri(m_kucb, m_noise);
-                    } else {
-					    pcur = pcur->select_best(m_kucb);
-                    }
+				}
+
+				vector<Evaluation<TGame>> evals = evaluate(leaves);
+				for (int j = 0; j < int(leaves.size()); ++j) {
+					leaves[j]->add_virtual_loss(-1);
+					leaves[j]->expand(std::move(evals[j]));
 				}
 			}
+			return i;
 		}
 
 		vector<MoveVisit<TGame>> get_moves() const {
@@ -149,6 +206,14 @@ namespace Maestro {
 			return m_root_game;
 		}
 
+		void print_stat() const override {
+			printf("eval: total=%d, batch=%d\n", m_eval_count, m_batch_count);
+			if (m_cache_lookups > 0) {
+				printf("eval cache: lookups=%d, hits=%d, hit_rate=%.1f%%\n",
+					m_cache_lookups, m_cache_hits, 100.0 * m_cache_hits / m_cache_lookups);
+			}
+		}
+
 		void move(Move<TGame> move) {
 			std::vector<MCTSNode<TGame>*>::iterator iter = m_root->m_children.begin();
 			for (; iter != m_root->m_children.end(); ++iter) {
@@ -157,24 +222,103 @@ namespace Maestro {
 				}
 			}
 			if (iter != m_root->m_children.end()) {
+				MCTSNode<TGame>* old_root = m_root;
 				m_root = *iter;
-				m_root->m_parent->m_children.erase(iter);
-				delete* iter;
+				old_root->m_children.erase(iter);
+				delete old_root;
 				m_root->m_parent = nullptr;
 				m_root_game.move(move);
 			} else {
-				// move doesn't exist
-				throw;
+				throw invalid_argument("move is not legal");
+			}
+			if (!m_root->expanded()) {
+				m_root->expand(m_root_game.get_status().end ? Evaluation<TGame>() : evaluate(m_root_game));
 			}
             root_expand2();
 		}
+		size_t node_count() const {
+			size_t n = 0;
+			for_each_node([&n](const MCTSNode<TGame>*) { n++; });
+			return n;
+		}
+
+		// heap bytes held by the nodes and their games, allocator overhead excluded
+		size_t memory_bytes() const {
+			size_t bytes = 0;
+			for_each_node([&bytes](const MCTSNode<TGame>* node) {
+				bytes += sizeof(MCTSNode<TGame>) + node->m_children.capacity() * sizeof(MCTSNode<TGame>*);
+				if (node->m_game) bytes += sizeof(TGame);
+			});
+			return bytes;
+		}
 	private:
+		template<typename F>
+		void for_each_node(F fn) const {
+			vector<const MCTSNode<TGame>*> stack{ m_root };
+			while (!stack.empty()) {
+				const MCTSNode<TGame>* node = stack.back();
+				stack.pop_back();
+				fn(node);
+				for (const MCTSNode<TGame>* child : node->m_children) {
+					stack.push_back(child);
+				}
+			}
+		}
+
+		Evaluation<TGame> evaluate(const TGame& game) {
+			Evaluation<TGame> eval;
+			if (m_cache) {
+				m_cache_lookups++;
+				if (m_cache->find(game, eval)) {
+					m_cache_hits++;
+					return eval;
+				}
+			}
+			m_eval_count++;
+			eval = m_evaluator->evaluate(game);
+			if (m_cache) {
+				m_cache->insert(game, eval);
+			}
+			return eval;
+		}
+
+		// evaluates the games of leaves, those not cached in one batch
+		vector<Evaluation<TGame>> evaluate(const vector<MCTSNode<TGame>*>& leaves) {
+			vector<Evaluation<TGame>> evals(leaves.size());
+			vector<TGame*> games;
+			vector<int> index;
+			for (int i = 0; i < int(leaves.size()); ++i) {
+				if (m_cache) {
+					m_cache_lookups++;
+					if (m_cache->find(*leaves[i]->m_game, evals[i])) {
+						m_cache_hits++;
+						continue;
+					}
+				}
+				games.push_back(leaves[i]->m_game);
+				index.push_back(i);
+			}
+			if (games.empty()) return evals;
+
+			m_eval_count += int(games.size());
+			m_batch_count++;
+			vector<Evaluation<TGame>> results = m_evaluator->evaluate(games);
+			for (int i = 0; i < int(games.size()); ++i) {
+				if (m_cache) {
+					m_cache->insert(*games[i], results[i]);
+				}
+				evals[index[i]] = std::move(results[i]);
+			}
+			return evals;
+		}
+
         // Fully expand root and generate dirichlet noise
         void root_expand2() {
-            vector<Move<TGame>> moves = m_root_game.get_all_legal_moves();
+            if (m_root_game.get_status().end) return;
             int children_size = m_root->m_children.size();
+            m_root->m_children.reserve(LegalMoves<TGame>::count(m_root_game));
 
-            for (Move<TGame>& m : moves) {
+            LegalMoves<TGame>::for_each(m_root_game, [&](Move<TGame> m) {
                 bool found = false;
                 for (int i = 0; i < children_size; ++i) {
                     if (m_root->m_children[i]->m_move.move == m) {
@@ -188,7 +332,7 @@ namespace Maestro {
                     new_node->m_game->move(m);
                     m_root->m_children.emplace_back(new_node);
                 }
-            }
+            });
             // : Dir(0.03)
             m_noise = rand_dirichlet(m_root->m_children.size(), 0.03);
         }
@@ -210,6 +354,10 @@ namespace Maestro {
 
 		MCTSNode<TGame>* m_root;
 		IEvaluator<TGame>* m_evaluator;
+		shared_ptr<EvaluationCache<TGame>> m_cache;
+		int m_eval_count = 0, m_batch_count = 0, m_cache_lookups = 0, m_cache_hits = 0;
+		int m_leaf_batch_count;
+		float m_virtual_loss;
 		TGame m_root_game;
 		float m_kucb;
         vector<float> m_noise;
@@ -0,0 +1,406 @@
+#pragma once
+#include "search_base.h"
+#include "../util/arena.h"
+#include "../evaluator/eval_cache.h"
+#include <stdexcept>
+#include <time.h>
+
+namespace Maestro {
+    using namespace std;
+
+    // The tree search of MonteCarloTreeSearch, with the tree laid out flat.
+    // The children of a node are one block of a NodeArena, and no node
+    // holds a game: the game of a node is rebuilt while descending, from
+    // the root game and the moves on the path. Expanding a node costs one
+    // block allocation instead of a game copy and a heap node per child.
+    // move() copies the subtree kept into a fresh arena and drops the old
+    // one in bulk.
+    template<typename TGame>
+    class CompactMonteCarloTreeSearch final : public IMonteCarloSearch<TGame> {
+    public:
+        struct Config {
+            bool same_response = false;
+            float puct = 2;
+            // Dir(0.03) noise on the root priors; moves without a prior get
+            // a child at the root too, so the noise can reach them
+            bool dirichlet_noise = true;
+            float noise_epsilon = 0.25;
+            // leaves gathered under virtual loss and evaluated in one batch,
+            // at most 255
+            int leaf_batch_count = 1;
+            float virtual_loss = 1;
+            // looked up before evaluating a leaf, may be shared with other searches
+            shared_ptr<EvaluationCache<TGame>> eval_cache;
+        };
+
+        struct Stat {
+            int sims = 0, evaluated = 0, game_end = 0;
+            // batches sent to the evaluator, and descents that ended a batch
+            // early on a leaf already in it
+            int batches = 0, collisions = 0;
+            int eval_cache_lookups = 0, eval_cache_hits = 0;
+            double sim_seconds = 0;
+            void print() const {
+                printf("sims: total=%d, game_end=%d, sims/sec=%.0f\n",
+                    sims, game_end, sim_seconds > 0 ? sims / sim_seconds : 0);
+                printf("eval: total=%d, batch=%d, collisions=%d\n", evaluated, batches, collisions);
+                if (eval_cache_lookups > 0) {
+                    printf("eval cache: lookups=%d, hits=%d, hit_rate=%.1f%%\n",
+                        eval_cache_lookups, eval_cache_hits, 100.0 * eval_cache_hits / eval_cache_lookups);
+                }
+            }
+        } stat = Stat();
+
+    private:
+        enum class NodeState : uint8_t {
+            leaf,
+            expanded,
+            // game end, or no move to expand; its value never changes
+            terminal
+        };
+
+        struct Node {
+            Move<TGame> move{};
+            float p = 0;
+            int n = 0;
+            // sum of the values backed up through the node, for the player
+            // who made its move
+            float w = 0;
+            NodeId first_child = NULL_NODE;
+            uint16_t n_children = 0;
+            NodeState state = NodeState::leaf;
+            // evaluations pending in the subtree, at most one batch
+            uint8_t vl = 0;
+        };
+
+        // a leaf waiting for its evaluation, and its path in _paths
+        struct PendingLeaf {
+            NodeId id;
+            int path_begin, path_size;
+        };
+
+        Config _config;
+        shared_ptr<IEvaluator<TGame>> _evaluator;
+        NodeArena<Node> _nodes;
+        NodeId _root;
+        TGame _root_game;
+        vector<float> _noise;
+        // nodes from the root to each leaf of the batch, one after another
+        vector<NodeId> _paths;
+        vector<PendingLeaf> _pending;
+        vector<TGame> _pending_games;
+
+        Evaluation<TGame> evaluate(const TGame& game) {
+            Evaluation<TGame> eval;
+            if (_config.eval_cache) {
+                stat.eval_cache_lookups++;
+                if (_config.eval_cache->find(game, eval)) {
+                    stat.eval_cache_hits++;
+                    return eval;
+                }
+            }
+            stat.evaluated++;
+            eval = _evaluator->evaluate(game);
+            if (_config.eval_cache) {
+                _config.eval_cache->insert(game, eval);
+            }
+            return eval;
+        }
+
+        // evaluates games, those not cached in one batch
+        vector<Evaluation<TGame>> evaluate(vector<TGame>& games) {
+            vector<Evaluation<TGame>> evals(games.size());
+            vector<TGame*> ptrs;
+            vector<int> index;
+            for (int i = 0; i < int(games.size()); i++) {
+                if (_config.eval_cache) {
+                    stat.eval_cache_lookups++;
+                    if (_config.eval_cache->find(games[i], evals[i])) {
+                        stat.eval_cache_hits++;
+                        continue;
+                    }
+                }
+                ptrs.push_back(&games[i]);
+                index.push_back(i);
+            }
+            if (ptrs.empty()) return evals;
+
+            stat.evaluated += int(ptrs.size());
+            stat.batches++;
+            vector<Evaluation<TGame>> results = _evaluator->evaluate(ptrs);
+            for (int i = 0; i < int(ptrs.size()); i++) {
+                if (_config.eval_cache) {
+                    _config.eval_cache->insert(*ptrs[i], results[i]);
+                }
+                evals[index[i]] = std::move(results[i]);
+            }
+            return evals;
+        }
+
+        // Marks the leaf of an ended game terminal and writes its value for
+        // the player to move to v.
+        bool end_game(NodeId id, const TGame& game, float& v) {
+            Status s = game.get_status();
+            if (!s.end) return false;
+            stat.game_end++;
+            _nodes[id].state = NodeState::terminal;
+            v = s.winner == Color::None ? 0.0f : s.winner == game.get_color() ? 1.0f : -1.0f;
+            return true;
+        }
+
+        // Expands a leaf and returns its value for the player to move.
+        float expand(NodeId id, const Evaluation<TGame>& eval) {
+            int n = int(eval.p.size());
+            if (n == 0) {
+                _nodes[id].state = NodeState::terminal;
+                return eval.v;
+            }
+            NodeId first = _nodes.alloc(n);
+            Node* children = &_nodes[first];
+            for (int i = 0; i < n; i++) {
+                children[i].move = eval.p[i].move;
+                children[i].p = eval.p[i].p;
+            }
+            Node& node = _nodes[id];
+            node.first_child = first;
+            node.n_children = uint16_t(n);
+            node.state = NodeState::expanded;
+            return eval.v;
+        }
+
+        NodeId select(NodeId id) {
+            const Node& node = _nodes[id];
+            const Node* children = &_nodes[node.first_child];
+            bool noise = id == _root && !_noise.empty();
+            float c = _config.puct * sqrt(float(node.n));
+            int best = 0;
+            float best_score = -INFINITY;
+            for (int i = 0; i < node.n_children; i++) {
+                const Node& ch = children[i];
+                float p = noise ? (1 - _config.noise_epsilon) * ch.p + _config.noise_epsilon * _noise[i] : ch.p;
+                // pending evaluations count as losses
+                int n = ch.n + ch.vl;
+                float q = n > 0 ? (ch.w - ch.vl * _config.virtual_loss) / n : 0;
+                float score = q + c * p / (1 + n);
+                if (score > best_score) {
+                    best_score = score;
+                    best = i;
+                }
+            }
+            return node.first_child + best;
+        }
+
+        // v is for the player to move at the end of the path
+        void backup(const NodeId* path, int n, float v) {
+            for (int i = n - 1; i >= 0; i--) {
+                Node& node = _nodes[path[i]];
+                v = -v;
+                node.n++;
+                node.w += v;
+            }
+        }
+
+        void add_virtual_loss(const NodeId* path, int n, int d) {
+            for (int i = 0; i < n; i++) {
+                _nodes[path[i]].vl += d;
+            }
+        }
+
+        // Expands the root, and with noise gives every legal move a child.
+        void prepare_root() {
+            Node& root = _nodes[_root];
+            if (root.state == NodeState::leaf) {
+                float v;
+                if (!end_game(_root, _root_game, v)) {
+                    v = expand(_root, evaluate(_root_game));
+                }
+                backup(&_root, 1, v);
+            }
+            _noise.clear();
+            if (!_config.dirichlet_noise || root.state != NodeState::expanded) return;
+
+            // the root's block is reallocated to hold every legal move
+            int n_moves = LegalMoves<TGame>::count(_root_game);
+            if (n_moves > root.n_children) {
+                NodeId first = _nodes.alloc(uint32_t(n_moves));
+                Node* children = &_nodes[first];
+                const Node* old_children = &_nodes[root.first_child];
+                int n = root.n_children;
+                copy(old_children, old_children + n, children);
+                LegalMoves<TGame>::for_each(_root_game, [&](Move<TGame> m) {
+                    bool found = false;
+                    for (int i = 0; i < root.n_children && !found; i++) {
+                        found = old_children[i].move == m;
+                    }
+                    if (!found) {
+                        children[n++].move = m;
+                    }
+                });
+                root.first_child = first;
+                root.n_children = uint16_t(n);
+            }
+            _noise = rand_dirichlet(root.n_children, 0.03f);
+        }
+
+        // Copies the subtree of new_root into a fresh arena and drops the old one.
+        void compact(NodeId new_root) {
+            NodeArena<Node> nodes;
+            NodeId root = nodes.alloc();
+            nodes[root] = _nodes[new_root];
+            vector<NodeId> stack{ root };
+            while (!stack.empty()) {
+                Node& node = nodes[stack.back()];
+                stack.pop_back();
+                if (node.n_children == 0) continue;
+                NodeId first = nodes.alloc(node.n_children);
+                const Node* old_children = &_nodes[node.first_child];
+                copy(old_children, old_children + node.n_children, &nodes[first]);
+                node.first_child = first;
+                for (int i = 0; i < node.n_children; i++) {
+                    stack.push_back(first + i);
+                }
+            }
+            _nodes.swap(nodes);
+            _root = root;
+        }
+
+        vector<float> rand_dirichlet(int n, float concentration) {
+            vector<float> ret(n, 0);
+            gamma_distribution<float> gamma(concentration, 1);
+            float sum = 0;
+            for (int i = 0; i < n; ++i) {
+                ret[i] = gamma(this->_rnd_eng);
+                sum += ret[i];
+            }
+            for (int i = 0; i < n; ++i) {
+                ret[i] = ret[i] / sum;
+            }
+            return ret;
+        }
+
+    public:
+        CompactMonteCarloTreeSearch(
+            shared_ptr<IEvaluator<TGame>> evaluator,
+            TGame game,
+            Config config = Config()) :
+            _config(config),
+            _evaluator(std::move(evaluator)),
+            _root_game(game)
+        {
+            if (!_config.same_response) {
+                // searches may be built on several threads at once
+                static atomic<int> seed{ 0 };
+                this->_rnd_eng.seed(seed += int(time(0)));
+            }
+            _root = _nodes.alloc();
+            prepare_root();
+        }
+
+        // A simulation is one descent from the root to a leaf. Descents
+        // gather leaves until leaf_batch_count are pending or one reaches a
+        // pending leaf, then the leaves are evaluated in one batch.
+        int simulate(int k) override {
+            auto start = chrono::steady_clock::now();
+            int batch_size = clamp(_config.leaf_batch_count, 1, 255);
+            int i = 0;
+            while (i < k && !this->_stop) {
+                _paths.clear();
+                _pending.clear();
+                _pending_games.clear();
+                int n = min(batch_size, k - i);
+                for (int j = 0; j < n; j++) {
+                    TGame game = _root_game;
+                    int begin = int(_paths.size());
+                    NodeId cur = _root;
+                    _paths.push_back(cur);
+                    while (_nodes[cur].state == NodeState::expanded) {
+                        cur = select(cur);
+                        game.move(_nodes[cur].move);
+                        _paths.push_back(cur);
+                    }
+                    int size = int(_paths.size()) - begin;
+                    const Node& leaf = _nodes[cur];
+                    if (leaf.vl > 0) {
+                        stat.collisions++;
+                        _paths.resize(begin);
+                        break;
+                    }
+                    i++;
+                    float v;
+                    if (leaf.state == NodeState::terminal) {
+                        stat.game_end++;
+                        backup(&_paths[begin], size, -leaf.w / leaf.n);
+                    } else if (end_game(cur, game, v)) {
+                        backup(&_paths[begin], size, v);
+                    } else {
+                        add_virtual_loss(&_paths[begin], size, 1);
+                        _pending.push_back(PendingLeaf{ cur, begin, size });
+                        _pending_games.push_back(std::move(game));
+                        continue;
+                    }
+                    _paths.resize(begin);
+                }
+
+                vector<Evaluation<TGame>> evals = evaluate(_pending_games);
+                for (int j = 0; j < int(_pending.size()); j++) {
+                    const PendingLeaf& pl = _pending[j];
+                    add_virtual_loss(&_paths[pl.path_begin], pl.path_size, -1);
+                    backup(&_paths[pl.path_begin], pl.path_size, expand(pl.id, evals[j]));
+                }
+            }
+            stat.sims += i;
+            stat.sim_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            return i;
+        }
+
+        vector<MoveVisit<TGame>> get_moves() const override {
+            vector<MoveVisit<TGame>> ret;
+            const Node& root = _nodes[_root];
+            for (int i = 0; i < root.n_children; i++) {
+                const Node& ch = _nodes[root.first_child + i];
+                ret.push_back(MoveVisit<TGame>{ ch.move, ch.n });
+            }
+            return ret;
+        }
+
+        float get_value(Color color) const override {
+            const Node& root = _nodes[_root];
+            float v = root.n > 0 ? -root.w / root.n : 0;
+            return _root_game.get_color() == color ? v : -v;
+        }
+
+        TGame get_game_snapshot() const override {
+            return _root_game;
+        }
+
+        void move(Move<TGame> move) override {
+            const Node& root = _nodes[_root];
+            NodeId next = NULL_NODE;
+            for (int i = 0; i < root.n_children && next == NULL_NODE; i++) {
+                if (_nodes[root.first_child + i].move == move) next = root.first_child + i;
+            }
+            if (next == NULL_NODE) {
+                if (!_root_game.is_legal_move(move)) throw invalid_argument("move is not legal");
+                // not in the tree, start over
+                _nodes.clear();
+                next = _nodes.alloc();
+                _nodes[next].move = move;
+            }
+            _root_game.move(move);
+            compact(next);
+            prepare_root();
+        }
+
+        void print_stat() const override {
+            stat.print();
+            printf("mem: nodes=%zu (%zuB), per node=%.0fB, pool=%.1fMB\n",
+                node_count(), sizeof(Node), double(memory_bytes()) / max<size_t>(1, node_count()),
+                memory_bytes() / 1048576.0);
+        }
+
+        size_t node_count() const { return _nodes.size(); }
+
+        // bytes of the arena chunks, in use or not
+        size_t memory_bytes() const { return _nodes.bytes(); }
+    };
+}
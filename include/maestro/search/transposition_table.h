@@ -0,0 +1,191 @@
+#pragma once
+#include "../util/spin_lock.h"
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+namespace Maestro {
+    using namespace std;
+
+    // Fixed-capacity hash table from 64-bit position hashes to values.
+    // Each bucket is one cache line holding BUCKET_SIZE keys and their
+    // generations behind a spin lock; values live in a parallel array.
+    // A full bucket replaces its oldest entry, and entries are refreshed to
+    // the current generation whenever they are found. Since hashes may
+    // collide, lookups verify candidates with a caller supplied predicate.
+    // expire() empties the table in constant time: each bucket records the
+    // epoch it was last written in and is emptied on its next use.
+    template<typename TValue>
+    class TranspositionTable {
+    public:
+        static const int BUCKET_SIZE = 7;
+
+    private:
+        struct alignas(64) Bucket {
+            SpinLock lock;
+            uint8_t gen[BUCKET_SIZE] = {};
+            uint64_t keys[BUCKET_SIZE] = {};
+        };
+
+        static_assert(sizeof(Bucket) == 64, "bucket should fill one cache line");
+
+        vector<Bucket> _buckets;
+        vector<TValue> _values;
+        vector<uint16_t> _epochs;
+        size_t _mask;
+        uint8_t _gen = 0;
+        uint16_t _epoch = 0;
+        atomic<size_t> _occupied{ 0 };
+        atomic<size_t> _replaced{ 0 };
+
+        // 0 marks an empty slot
+        static uint64_t to_key(uint64_t hash) { return hash ? hash : 1; }
+
+        Bucket& bucket(uint64_t key) { return _buckets[key & _mask]; }
+
+        // drops the entries of a bucket last written before expire(); its lock must be held
+        void refresh(Bucket& b) {
+            size_t i = &b - _buckets.data();
+            if (_epochs[i] == _epoch) return;
+            _epochs[i] = _epoch;
+            for (int k = 0; k < BUCKET_SIZE; k++) {
+                if (b.keys[k] != 0) {
+                    b.keys[k] = 0;
+                    b.gen[k] = 0;
+                    _values[i * BUCKET_SIZE + k] = TValue();
+                }
+            }
+        }
+
+        TValue& value(const Bucket& b, int slot) { return _values[(&b - _buckets.data()) * BUCKET_SIZE + slot]; }
+
+        template<typename Eq>
+        int find_slot(Bucket& b, uint64_t key, Eq& eq) {
+            for (int i = 0; i < BUCKET_SIZE; i++) {
+                if (b.keys[i] == key && eq(value(b, i))) {
+                    b.gen[i] = _gen;
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+    public:
+        // capacity is rounded up to a power of two buckets
+        explicit TranspositionTable(size_t capacity) {
+            size_t n = 1;
+            while (n * BUCKET_SIZE < capacity) n <<= 1;
+            _buckets = vector<Bucket>(n);
+            _values.resize(n * BUCKET_SIZE);
+            _epochs.resize(n);
+            _mask = n - 1;
+        }
+
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        // Looks up the value for which eq(value) holds.
+        template<typename Eq>
+        bool find(uint64_t hash, Eq eq, TValue& out) {
+            uint64_t key = to_key(hash);
+            Bucket& b = bucket(key);
+            SpinLockGuard guard(b.lock);
+            refresh(b);
+            int slot = find_slot(b, key, eq);
+            if (slot < 0) return false;
+            out = value(b, slot);
+            return true;
+        }
+
+        // Returns the value for which eq(value) holds; otherwise stores and
+        // returns make(). Both run atomically with respect to other callers.
+        template<typename Eq, typename Make>
+        TValue find_or_insert(uint64_t hash, Eq eq, Make make) {
+            uint64_t key = to_key(hash);
+            Bucket& b = bucket(key);
+            SpinLockGuard guard(b.lock);
+            refresh(b);
+            int slot = find_slot(b, key, eq);
+            if (slot >= 0) return value(b, slot);
+
+            // take an empty slot, or evict the oldest entry
+            int victim = 0;
+            int victim_age = -1;
+            for (int i = 0; i < BUCKET_SIZE; i++) {
+                if (b.keys[i] == 0) {
+                    victim = i;
+                    break;
+                }
+                int age = uint8_t(_gen - b.gen[i]);
+                if (age > victim_age) {
+                    victim = i;
+                    victim_age = age;
+                }
+            }
+            if (b.keys[victim] == 0) {
+                ++_occupied;
+            }
+            else {
+                ++_replaced;
+            }
+
+            b.keys[victim] = key;
+            b.gen[victim] = _gen;
+            value(b, victim) = make();
+            return value(b, victim);
+        }
+
+        // Drops every entry whose value satisfies pred.
+        // Not safe to call concurrently with other operations.
+        template<typename Pred>
+        void erase_if(Pred pred) {
+            for (Bucket& b : _buckets) {
+                refresh(b);
+                for (int i = 0; i < BUCKET_SIZE; i++) {
+                    if (b.keys[i] != 0 && pred(value(b, i))) {
+                        b.keys[i] = 0;
+                        value(b, i) = TValue();
+                        --_occupied;
+                    }
+                }
+            }
+        }
+
+        // Drops every entry. Not safe to call concurrently with other operations.
+        void clear() {
+            for (Bucket& b : _buckets) {
+                for (int i = 0; i < BUCKET_SIZE; i++) {
+                    b.keys[i] = 0;
+                    b.gen[i] = 0;
+                }
+            }
+            fill(_values.begin(), _values.end(), TValue());
+            fill(_epochs.begin(), _epochs.end(), 0);
+            _occupied = 0;
+            _gen = 0;
+            _epoch = 0;
+        }
+
+        // Drops every entry like clear(), but leaves the work to the next
+        // use of each bucket. Not safe to call concurrently with other operations.
+        void expire() {
+            if (_epoch == UINT16_MAX) {
+                clear();
+                return;
+            }
+            ++_epoch;
+            _occupied = 0;
+        }
+
+        // Ages all current entries by one, making them preferred victims.
+        void next_generation() { ++_gen; }
+
+        size_t capacity() const { return _values.size(); }
+        size_t size() const { return _occupied; }
+        size_t replaced() const { return _replaced; }
+        float load_factor() const { return float(size()) / capacity(); }
+        size_t bytes() const { return _buckets.size() * sizeof(Bucket) + _values.size() * sizeof(TValue); }
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "spin_lock.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
+
+namespace Maestro {
+    using namespace std;
+
+    using NodeId = uint32_t;
+    const NodeId NULL_NODE = UINT32_MAX;
+
+    // Chunked node arena addressed by 32-bit ids. Nodes never move, so
+    // references stay valid until the whole arena is released; there is no
+    // per-node free. Blocks from alloc() are contiguous and never straddle
+    // a chunk. Allocation is thread-safe; lookup is lock-free.
+    template<typename T, int CHUNK_BITS = 12>
+    class NodeArena {
+    public:
+        static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+        static const uint32_t MAX_CHUNKS = 1u << 14;
+
+    private:
+        vector<unique_ptr<T[]>> _chunks;
+        uint32_t _n_chunks = 0;
+        uint32_t _size = 0;
+        uint32_t _used = 0;
+        SpinLock _lock;
+
+    public:
+        NodeArena() : _chunks(MAX_CHUNKS) {}
+
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        // Returns the id of the first of n consecutive default-constructed nodes.
+        NodeId alloc(uint32_t n = 1) {
+            assert(n > 0 && n <= CHUNK_SIZE);
+            SpinLockGuard guard(_lock);
+            uint32_t offset = _size & (CHUNK_SIZE - 1);
+            if (_size == _n_chunks * CHUNK_SIZE || offset + n > CHUNK_SIZE) {
+                if (_n_chunks == MAX_CHUNKS) throw runtime_error("node arena exhausted");
+                _chunks[_n_chunks] = unique_ptr<T[]>(new T[CHUNK_SIZE]);
+                _size = _n_chunks * CHUNK_SIZE;
+                _n_chunks++;
+            }
+            NodeId id = _size;
+            _size += n;
+            _used += n;
+            return id;
+        }
+
+        T& operator[](NodeId id) {
+            return _chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+        }
+
+        const T& operator[](NodeId id) const {
+            return _chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+        }
+
+        // nodes handed out, excluding chunk tails skipped by alloc()
+        uint32_t size() const { return _used; }
+        // memory held by the chunks, constructed or not
+        size_t bytes() const { return size_t(_n_chunks) * CHUNK_SIZE * sizeof(T); }
+
+        // Drops every node at once.
+        void clear() {
+            for (uint32_t i = 0; i < _n_chunks; i++) {
+                _chunks[i].reset();
+            }
+            _n_chunks = 0;
+            _size = 0;
+            _used = 0;
+        }
+
+        void swap(NodeArena& other) {
+            _chunks.swap(other._chunks);
+            std::swap(_n_chunks, other._n_chunks);
+            std::swap(_size, other._size);
+            std::swap(_used, other._used);
+        }
+    };
+}
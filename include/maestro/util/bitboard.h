@@ -0,0 +1,241 @@
+#pragma once
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Maestro {
+    using namespace std;
+
+    // index of the lowest set bit, w must not be 0
+    inline int lowest_bit(uint64_t w) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long i;
+        _BitScanForward64(&i, w);
+        return int(i);
+#elif defined(_MSC_VER)
+        // 32-bit targets have no 64-bit scan
+        unsigned long i;
+        if (_BitScanForward(&i, uint32_t(w))) return int(i);
+        _BitScanForward(&i, uint32_t(w >> 32));
+        return int(i) + 32;
+#else
+        return __builtin_ctzll(w);
+#endif
+    }
+
+    // number of set bits
+    inline int popcount(uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_IX86)
+        return int(__popcnt(uint32_t(w)) + __popcnt(uint32_t(w >> 32)));
+#elif defined(_MSC_VER)
+        return int(__popcnt64(w));
+#else
+        return __builtin_popcountll(w);
+#endif
+    }
+
+    // 256-bit set stored as four 64-bit words, bit i lives in word i >> 6.
+    // Shifts move bit i to i - N (shr) or i + N (shl), so with a row-major
+    // board layout a shift by the row stride steps a whole row at once.
+    class Bits256 {
+#ifdef __AVX2__
+        union {
+            uint64_t _w[4];
+            __m256i _v;
+        };
+        explicit Bits256(__m256i v) : _v(v) {}
+#else
+        alignas(32) uint64_t _w[4];
+#endif
+
+    public:
+        Bits256() : _w{ 0, 0, 0, 0 } {}
+        Bits256(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3) : _w{ w0, w1, w2, w3 } {}
+
+        bool test(int i) const { return (_w[i >> 6] >> (i & 63)) & 1; }
+        void set(int i) { _w[i >> 6] |= uint64_t(1) << (i & 63); }
+        void reset(int i) { _w[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+        void set(int i, bool value) { if (value) set(i); else reset(i); }
+
+        uint64_t word(int k) const { return _w[k]; }
+
+        int count() const { return popcount(_w[0]) + popcount(_w[1]) + popcount(_w[2]) + popcount(_w[3]); }
+
+        // calls f(i) for every set bit i in increasing order
+        template<typename F>
+        void for_each(F f) const {
+            for (int k = 0; k < 4; k++) {
+                for (uint64_t w = _w[k]; w; w &= w - 1) {
+                    f((k << 6) | lowest_bit(w));
+                }
+            }
+        }
+
+        // Walks the set bits in increasing order; the set must outlive it.
+        class iterator {
+            const uint64_t* _w;
+            int _k;
+            // bits of word _k not visited yet
+            uint64_t _rest;
+            void skip_empty() {
+                while (_rest == 0 && _k < 4) {
+                    if (++_k < 4) _rest = _w[_k];
+                }
+            }
+        public:
+            iterator(const uint64_t* w, int k) : _w(w), _k(k), _rest(k < 4 ? w[k] : 0) { skip_empty(); }
+            int operator*() const { return (_k << 6) | lowest_bit(_rest); }
+            iterator& operator++() {
+                _rest &= _rest - 1;
+                skip_empty();
+                return *this;
+            }
+            bool operator==(const iterator& it) const { return _k == it._k && _rest == it._rest; }
+            bool operator!=(const iterator& it) const { return !(*this == it); }
+        };
+        iterator begin() const { return iterator(_w, 0); }
+        iterator end() const { return iterator(_w, 4); }
+
+        bool none() const {
+#ifdef __AVX2__
+            return _mm256_testz_si256(_v, _v);
+#else
+            return (_w[0] | _w[1] | _w[2] | _w[3]) == 0;
+#endif
+        }
+        bool any() const { return !none(); }
+
+        bool operator==(const Bits256& b) const {
+            return ((_w[0] ^ b._w[0]) | (_w[1] ^ b._w[1]) | (_w[2] ^ b._w[2]) | (_w[3] ^ b._w[3])) == 0;
+        }
+        bool operator!=(const Bits256& b) const { return !(*this == b); }
+        // orders by the highest differing word, then bit
+        bool operator<(const Bits256& b) const {
+            for (int k = 3; k >= 0; k--) {
+                if (_w[k] != b._w[k]) return _w[k] < b._w[k];
+            }
+            return false;
+        }
+
+#ifdef __AVX2__
+        Bits256 operator&(const Bits256& b) const { return Bits256(_mm256_and_si256(_v, b._v)); }
+        Bits256 operator|(const Bits256& b) const { return Bits256(_mm256_or_si256(_v, b._v)); }
+        Bits256 operator^(const Bits256& b) const { return Bits256(_mm256_xor_si256(_v, b._v)); }
+        // *this & ~b
+        Bits256 and_not(const Bits256& b) const { return Bits256(_mm256_andnot_si256(b._v, _v)); }
+        Bits256 operator~() const { return Bits256(_mm256_xor_si256(_v, _mm256_set1_epi64x(-1))); }
+#else
+        Bits256 operator&(const Bits256& b) const { return Bits256(_w[0] & b._w[0], _w[1] & b._w[1], _w[2] & b._w[2], _w[3] & b._w[3]); }
+        Bits256 operator|(const Bits256& b) const { return Bits256(_w[0] | b._w[0], _w[1] | b._w[1], _w[2] | b._w[2], _w[3] | b._w[3]); }
+        Bits256 operator^(const Bits256& b) const { return Bits256(_w[0] ^ b._w[0], _w[1] ^ b._w[1], _w[2] ^ b._w[2], _w[3] ^ b._w[3]); }
+        Bits256 and_not(const Bits256& b) const { return Bits256(_w[0] & ~b._w[0], _w[1] & ~b._w[1], _w[2] & ~b._w[2], _w[3] & ~b._w[3]); }
+        Bits256 operator~() const { return Bits256(~_w[0], ~_w[1], ~_w[2], ~_w[3]); }
+#endif
+        Bits256& operator&=(const Bits256& b) { return *this = *this & b; }
+        Bits256& operator|=(const Bits256& b) { return *this = *this | b; }
+
+        // bit i of the result is bit i + N of this
+        template<int N>
+        Bits256 shr() const {
+            static_assert(N >= 0 && N < 256, "shift out of range");
+            constexpr int q = N >> 6, b = N & 63;
+#ifdef __AVX2__
+            __m256i lo = word_shr<q>(_v);
+            if constexpr (b == 0) {
+                return Bits256(lo);
+            }
+            else {
+                __m256i hi = word_shr<q + 1>(_v);
+                return Bits256(_mm256_or_si256(_mm256_srli_epi64(lo, b), _mm256_slli_epi64(hi, 64 - b)));
+            }
+#else
+            Bits256 r;
+            for (int i = 0; i < 4; i++) {
+                uint64_t lo = i + q < 4 ? _w[i + q] : 0;
+                uint64_t hi = i + q + 1 < 4 ? _w[i + q + 1] : 0;
+                r._w[i] = b == 0 ? lo : (lo >> b) | (hi << ((64 - b) & 63));
+            }
+            return r;
+#endif
+        }
+
+        // bit i of the result is bit i - N of this
+        template<int N>
+        Bits256 shl() const {
+            static_assert(N >= 0 && N < 256, "shift out of range");
+            constexpr int q = N >> 6, b = N & 63;
+#ifdef __AVX2__
+            __m256i hi = word_shl<q>(_v);
+            if constexpr (b == 0) {
+                return Bits256(hi);
+            }
+            else {
+                __m256i lo = word_shl<q + 1>(_v);
+                return Bits256(_mm256_or_si256(_mm256_slli_epi64(hi, b), _mm256_srli_epi64(lo, 64 - b)));
+            }
+#else
+            Bits256 r;
+            for (int i = 0; i < 4; i++) {
+                uint64_t hi = i - q >= 0 ? _w[i - q] : 0;
+                uint64_t lo = i - q - 1 >= 0 ? _w[i - q - 1] : 0;
+                r._w[i] = b == 0 ? hi : (hi << b) | (lo >> ((64 - b) & 63));
+            }
+            return r;
+#endif
+        }
+
+        // swaps bit i and bit i + D for every i in mask; mask must not
+        // overlap itself shifted by D
+        template<int D>
+        Bits256 delta_swap(const Bits256& mask) const {
+            Bits256 t = (*this ^ shr<D>()) & mask;
+            return *this ^ t ^ t.template shl<D>();
+        }
+
+        // Symmetries of the set read as a 16x16 matrix, bit i at row i >> 4
+        // and column i & 15: transposed, columns reversed, rows reversed.
+        Bits256 transpose16() const {
+            Bits256 r = delta_swap<15>(Bits256(0x0000AAAA0000AAAA, 0x0000AAAA0000AAAA, 0x0000AAAA0000AAAA, 0x0000AAAA0000AAAA));
+            r = r.delta_swap<30>(Bits256(0x00000000CCCCCCCC, 0x00000000CCCCCCCC, 0x00000000CCCCCCCC, 0x00000000CCCCCCCC));
+            r = r.delta_swap<60>(Bits256(0xF0F0F0F0F0F0F0F0, 0, 0xF0F0F0F0F0F0F0F0, 0));
+            return r.delta_swap<120>(Bits256(0xFF00FF00FF00FF00, 0xFF00FF00FF00FF00, 0, 0));
+        }
+        Bits256 flip_cols16() const {
+            Bits256 r = delta_swap<1>(Bits256(0x5555555555555555, 0x5555555555555555, 0x5555555555555555, 0x5555555555555555));
+            r = r.delta_swap<2>(Bits256(0x3333333333333333, 0x3333333333333333, 0x3333333333333333, 0x3333333333333333));
+            r = r.delta_swap<4>(Bits256(0x0F0F0F0F0F0F0F0F, 0x0F0F0F0F0F0F0F0F, 0x0F0F0F0F0F0F0F0F, 0x0F0F0F0F0F0F0F0F));
+            return r.delta_swap<8>(Bits256(0x00FF00FF00FF00FF, 0x00FF00FF00FF00FF, 0x00FF00FF00FF00FF, 0x00FF00FF00FF00FF));
+        }
+        Bits256 flip_rows16() const {
+            Bits256 r = delta_swap<16>(Bits256(0x0000FFFF0000FFFF, 0x0000FFFF0000FFFF, 0x0000FFFF0000FFFF, 0x0000FFFF0000FFFF));
+            r = r.delta_swap<32>(Bits256(0x00000000FFFFFFFF, 0x00000000FFFFFFFF, 0x00000000FFFFFFFF, 0x00000000FFFFFFFF));
+            r = r.delta_swap<64>(Bits256(~uint64_t(0), 0, ~uint64_t(0), 0));
+            return r.delta_swap<128>(Bits256(~uint64_t(0), ~uint64_t(0), 0, 0));
+        }
+
+    private:
+#ifdef __AVX2__
+        // move whole words towards lane 0 (shr) or lane 3 (shl), filling with zero
+        template<int Q>
+        static __m256i word_shr(__m256i v) {
+            if constexpr (Q == 0) return v;
+            else if constexpr (Q == 1) return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x39), _mm256_setzero_si256(), 0xC0);
+            else if constexpr (Q == 2) return _mm256_permute2x128_si256(v, v, 0x81);
+            else if constexpr (Q == 3) return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x03), _mm256_setzero_si256(), 0xFC);
+            else return _mm256_setzero_si256();
+        }
+        template<int Q>
+        static __m256i word_shl(__m256i v) {
+            if constexpr (Q == 0) return v;
+            else if constexpr (Q == 1) return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), _mm256_setzero_si256(), 0x03);
+            else if constexpr (Q == 2) return _mm256_permute2x128_si256(v, v, 0x08);
+            else if constexpr (Q == 3) return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x00), _mm256_setzero_si256(), 0x3F);
+            else return _mm256_setzero_si256();
+        }
+#endif
+    };
+}
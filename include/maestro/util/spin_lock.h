@@ -5,12 +5,14 @@ namespace Maestro {
     using namespace std;
     
     class SpinLock {
-        atomic<bool> _latch;
+        atomic<bool> _latch{ false };
     public:
         void lock() {
             bool unlatched = false;
             while (!_latch.compare_exchange_weak(unlatched, true, std::memory_order_acquire)) {
                 unlatched = false;
+                // wait on a plain load so the cache line is not bounced while held
+                while (_latch.load(std::memory_order_relaxed)) {}
             }
         }
         void unlock() {
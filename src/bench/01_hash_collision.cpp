@@ -0,0 +1,100 @@
+#include "bench.h"
+#include <maestro/game/game_gomoku.h>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <random>
+
+using namespace Maestro;
+
+namespace {
+    struct Position {
+        uint64_t words[8];
+        bool operator<(const Position& p) const { return lexicographical_compare(words, words + 8, p.words, p.words + 8); }
+        bool operator==(const Position& p) const { return equal(words, words + 8, p.words); }
+    };
+
+    Position to_position(const Gomoku& g) {
+        Position p;
+        for (int k = 0; k < 4; k++) {
+            p.words[k] = g.black.bits().word(k);
+            p.words[k + 4] = g.white.bits().word(k);
+        }
+        return p;
+    }
+
+    // the hash Gomoku used before Zobrist keys
+    size_t legacy_hash(const Gomoku& g, int steps) {
+        bitset<256> b, w;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                b[(r << 4) | c] = g.black.get(r, c);
+                w[(r << 4) | c] = g.white.get(r, c);
+            }
+        }
+        return hash<int>()(steps) ^ hash<bitset<256>>()(b) ^ hash<bitset<256>>()(w);
+    }
+
+    template<typename T>
+    size_t count_distinct(vector<T> v) {
+        sort(v.begin(), v.end());
+        return unique(v.begin(), v.end()) - v.begin();
+    }
+
+    void report(const char* name, const vector<size_t>& hashes, size_t n_positions) {
+        // unordered_map keeps about one bucket per entry
+        size_t n_buckets = n_positions | 1;
+        vector<size_t> buckets;
+        buckets.reserve(hashes.size());
+        for (size_t h : hashes) buckets.push_back(h % n_buckets);
+        size_t n_hash = count_distinct(hashes);
+        size_t n_bucket = count_distinct(buckets);
+        printf("%-8s: hash collisions=%zu (%.4f%%), occupied buckets=%zu (%.2f%%)\n",
+            name, n_positions - n_hash, 100.0 * (n_positions - n_hash) / n_positions,
+            n_bucket, 100.0 * n_bucket / n_buckets);
+    }
+}
+
+BENCH_CASE(hash_collision) {
+    // positions of a wide random tree: many random games from a few shared openings
+    const int n_games = 20000;
+    minstd_rand rnd_eng(2020);
+    vector<Position> positions;
+    vector<size_t> zobrist, legacy;
+
+    for (int i = 0; i < n_games; i++) {
+        Gomoku g;
+        int steps = 0;
+        while (!g.get_status().end) {
+            auto moves = g.get_all_legal_moves();
+            uniform_int_distribution<int> dist(0, int(moves.size()) - 1);
+            Move<Gomoku> m = moves[dist(rnd_eng)];
+            // open near the center so games share many positions
+            if (steps < 4) m = Move<Gomoku>{ 6 + int(rnd_eng() % 3), 6 + int(rnd_eng() % 3) };
+            if (!g.is_legal_move(m)) continue;
+            g.move(m);
+            steps++;
+
+            positions.push_back(to_position(g));
+            zobrist.push_back(g.get_hash());
+            legacy.push_back(legacy_hash(g, steps));
+        }
+    }
+
+    // keep one sample per distinct position
+    vector<size_t> order(positions.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return positions[a] < positions[b]; });
+    vector<size_t> zobrist_u, legacy_u;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i > 0 && positions[order[i]] == positions[order[i - 1]]) continue;
+        zobrist_u.push_back(zobrist[order[i]]);
+        legacy_u.push_back(legacy[order[i]]);
+    }
+
+    size_t n = zobrist_u.size();
+    printf("positions: visited=%zu, distinct=%zu\n", positions.size(), n);
+    report("legacy", legacy_u, n);
+    report("zobrist", zobrist_u, n);
+    printf("ideal   : occupied buckets=%.2f%%\n", 100.0 * (1 - exp(-1.0)));
+}
@@ -0,0 +1,138 @@
+#include "bench.h"
+#include <maestro/search/search_graph.h>
+#include <maestro/search/search_tree.h>
+#include <maestro/search/search_tree_compact.h>
+#include <maestro/game/game_gomoku.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_async.h>
+#include <thread>
+
+using namespace Maestro;
+
+namespace {
+    // stands in for an accelerator: a fixed launch latency plus a small
+    // per position cost, spent off the CPU
+    class LatencyEvaluator final : public IEvaluator<Gomoku> {
+        SimplisticGomokuEvaluator _evaluator;
+    public:
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            return _evaluator.evaluate(game);
+        }
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override {
+            this_thread::sleep_for(chrono::microseconds(500 + 10 * games.size()));
+            return IEvaluator<Gomoku>::evaluate(games);
+        }
+    };
+}
+
+BENCH_CASE(graph_search_threads) {
+    const int n_sim = 20000;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+    g.move(Move<Gomoku>{ 7, 8 });
+    g.move(Move<Gomoku>{ 8, 8 });
+
+    int max_threads = max(1, int(thread::hardware_concurrency()));
+    double base = 0;
+    for (int n = 1; n <= max_threads; n *= 2) {
+        MonteCarloGraphSearch<Gomoku>::Config c;
+        c.same_response = true;
+        c.n_threads = n;
+        MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+        search.simulate(n_sim);
+        double sps = search.global_stat.sims_per_sec();
+        if (n == 1) base = sps;
+        printf("threads=%2d, sims/sec=%9.0f, speedup=%.2f, transposed=%d, visit_evaluating=%d\n",
+            n, sps, sps / base, search.global_stat.sim_use_transposition, search.global_stat.visit_evaluating);
+    }
+}
+
+BENCH_CASE(graph_search_memory) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    MonteCarloGraphSearch<Gomoku> search(eval, Gomoku(), c);
+    for (int n_sim : { 1000, 10000, 100000 }) {
+        search.simulate(n_sim);
+        auto& stat = search.global_stat;
+        printf("sims=%6d, states=%7zu, actions=%8zu, per state=%.0fB, arena=%.1fMB, tt=%.1fMB\n",
+            stat.sim_total, stat.n_states, stat.n_actions, stat.bytes_per_state(),
+            stat.mem_arena / 1048576.0, stat.mem_tt / 1048576.0);
+    }
+}
+
+BENCH_CASE(graph_search_async) {
+    const int n_sim = 4000;
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+    g.move(Move<Gomoku>{ 7, 8 });
+    g.move(Move<Gomoku>{ 8, 8 });
+
+    for (int depth : { 0, 1, 2, 4, 8 }) {
+        shared_ptr<IEvaluator<Gomoku>> eval = make_shared<LatencyEvaluator>();
+        if (depth > 0) {
+            eval = make_shared<AsyncEvaluator<Gomoku>>(eval, 4);
+        }
+        MonteCarloGraphSearch<Gomoku>::Config c;
+        c.same_response = true;
+        c.eval_queue_depth = depth;
+        MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+        search.simulate(n_sim);
+        auto& stat = search.global_stat;
+        printf("queue depth=%d, sims/sec=%7.0f, evals=%d, batches=%d, utilization=%5.1f%%, wait=%.3fs, visit_evaluating=%d\n",
+            depth, stat.sims_per_sec(), stat.node_evaluated_total, stat.eval_batch_count,
+            100 * stat.eval_utilization(), stat.eval_wait_seconds, stat.visit_evaluating);
+    }
+}
+
+BENCH_CASE(graph_search_move) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    for (bool background : { false, true }) {
+        MonteCarloGraphSearch<Gomoku>::Config c;
+        c.same_response = true;
+        c.background_free = background;
+        MonteCarloGraphSearch<Gomoku> search(eval, Gomoku(), c);
+        for (int i = 0; i < 20 && !search.get_game_snapshot().get_status().end; i++) {
+            search.simulate(5000);
+            search.move(search.pick_move(0));
+        }
+        auto& stat = search.global_stat;
+        printf("background_free=%d: moves=%d, move time mean=%.3fms max=%.3fms, last kept=%zu dropped=%zu\n",
+            int(background), stat.gc_moves, stat.gc_seconds / stat.gc_moves * 1e3, stat.gc_max_seconds * 1e3,
+            stat.gc_kept, stat.gc_dropped);
+    }
+}
+
+// the three engines on one batched evaluator, a single thread each
+BENCH_CASE(search_engines_batched) {
+    const int n_sim = 2000;
+    auto eval = make_shared<LatencyEvaluator>();
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+    g.move(Move<Gomoku>{ 7, 8 });
+    g.move(Move<Gomoku>{ 8, 8 });
+
+    for (int batch : { 1, 8, 32 }) {
+        MonteCarloGraphSearch<Gomoku>::Config gc;
+        gc.same_response = true;
+        gc.leaf_batch_count = batch;
+        MonteCarloGraphSearch<Gomoku> graph(eval, g, gc);
+        graph.simulate(n_sim);
+        printf("batch=%2d graph:   sims/sec=%7.0f, evals=%d, batches=%d\n",
+            batch, graph.global_stat.sims_per_sec(), graph.global_stat.node_evaluated_total, graph.global_stat.eval_batch_count);
+
+        CompactMonteCarloTreeSearch<Gomoku>::Config tc;
+        tc.same_response = true;
+        tc.leaf_batch_count = batch;
+        CompactMonteCarloTreeSearch<Gomoku> compact(eval, g, tc);
+        compact.simulate(n_sim);
+        printf("batch=%2d compact: sims/sec=%7.0f, evals=%d, batches=%d, collisions=%d\n",
+            batch, compact.stat.sims / compact.stat.sim_seconds, compact.stat.evaluated, compact.stat.batches, compact.stat.collisions);
+
+        MonteCarloTreeSearch<Gomoku> heap(&g, 2, eval.get(), nullptr, batch);
+        double start = bench_clock();
+        heap.simulate(n_sim);
+        printf("batch=%2d heap:    sims/sec=%7.0f\n", batch, n_sim / (bench_clock() - start));
+    }
+}
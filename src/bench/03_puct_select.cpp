@@ -0,0 +1,182 @@
+#include "bench.h"
+#include <maestro/search/puct.h>
+#include <maestro/game/game_gomoku.h>
+#include <maestro/util/lazy.h>
+#include <maestro/util/expirable.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+using namespace Maestro;
+
+namespace {
+    const int N_PARENTS = 512;
+    const int N_CHILDREN = BOARD_SIZE * BOARD_SIZE;
+    const float PUCT = 2, VIRTUAL_LOSS = 1;
+
+    // the node layout selection walked before edge lanes
+    struct LegacyAction;
+
+    struct LegacyState : public enable_shared_from_this<LegacyState> {
+        bool stop_selection = false;
+        bool evaluated = false;
+        Gomoku game;
+        int ns = 0;
+        float v = 0;
+        Expirable<float> dv;
+        Expirable<int> virtual_loss_cnt;
+        vector<weak_ptr<LegacyAction>> parent_actions;
+        Lazy<vector<shared_ptr<LegacyAction>>> child_actions;
+
+        float convert_v(LegacyState* state) const {
+            return state->game.get_color() == game.get_color() ? state->v : -state->v;
+        }
+    };
+
+    struct LegacyAction : public enable_shared_from_this<LegacyAction> {
+        Move<Gomoku> move;
+        int visit = 0;
+        float p = 0;
+        float p_noise_delta = 0;
+        weak_ptr<LegacyState> parent_state;
+        Lazy<shared_ptr<LegacyState>> child_state;
+    };
+
+    float legacy_ucb(LegacyState* parent, LegacyAction* action, int ts) {
+        float u = 1;
+        if (action->child_state.initialized()) {
+            LegacyState* child = action->child_state.value().get();
+            u += parent->convert_v(child);
+            u -= child->virtual_loss_cnt(ts) * VIRTUAL_LOSS / max(1, child->ns);
+        }
+        u += PUCT * (action->p + action->p_noise_delta) * sqrtf(parent->ns) / (1 + action->visit);
+        return u;
+    }
+
+    int legacy_select(LegacyState* parent, int ts) {
+        vector<shared_ptr<LegacyAction>>& actions = parent->child_actions.value();
+        vector<float> ac_ucb_temp;
+        ac_ucb_temp.reserve(actions.size());
+        int max_idx = -1;
+        float max_ucb = -100000;
+        int idx = 0;
+        for (auto& ac : actions) {
+            float ucb = legacy_ucb(parent, ac.get(), ts);
+            ac_ucb_temp.push_back(ucb);
+            if (ucb >= max_ucb) {
+                max_ucb = ucb;
+                max_idx = idx;
+            }
+            idx++;
+        }
+        return max_idx;
+    }
+
+    // statistics of one edge, shared by both layouts
+    struct EdgeSample {
+        float p, v;
+        int visit, vl;
+        bool expanded;
+    };
+
+    template<typename F>
+    double time_per_step(F select, int steps) {
+        int sink = 0;
+        for (int i = 0; i < steps / 10; i++) sink += select(i); // warm up
+        double start = bench_clock();
+        for (int i = 0; i < steps; i++) sink += select(i);
+        double t = bench_clock() - start;
+        if (sink == -1) printf("unreachable\n");
+        return t / steps;
+    }
+}
+
+BENCH_CASE(puct_select) {
+    const int steps = 200000;
+    minstd_rand rnd_eng(2020);
+    uniform_real_distribution<float> unit(0, 1);
+
+    vector<vector<EdgeSample>> samples(N_PARENTS, vector<EdgeSample>(N_CHILDREN));
+    vector<int> parent_ns(N_PARENTS);
+    for (int k = 0; k < N_PARENTS; k++) {
+        parent_ns[k] = 0;
+        for (auto& e : samples[k]) {
+            e.p = unit(rnd_eng) / N_CHILDREN;
+            e.expanded = unit(rnd_eng) < 0.5f;
+            e.visit = e.expanded ? rnd_eng() % 40 : 0;
+            e.v = e.expanded ? unit(rnd_eng) * 2 - 1 : 0;
+            e.vl = e.visit > 0 ? rnd_eng() % 2 : 0;
+            parent_ns[k] += e.visit;
+        }
+    }
+
+    // legacy graph, children allocated in search order rather than per parent
+    vector<shared_ptr<LegacyState>> parents;
+    vector<pair<int, int>> creation;
+    for (int k = 0; k < N_PARENTS; k++) {
+        auto s = make_shared<LegacyState>();
+        s->ns = parent_ns[k];
+        s->child_actions = []() { return vector<shared_ptr<LegacyAction>>(); };
+        s->child_actions.value().resize(N_CHILDREN);
+        parents.push_back(s);
+        for (int i = 0; i < N_CHILDREN; i++) creation.emplace_back(k, i);
+    }
+    shuffle(creation.begin(), creation.end(), rnd_eng);
+    for (auto& ki : creation) {
+        const EdgeSample& e = samples[ki.first][ki.second];
+        auto ac = make_shared<LegacyAction>();
+        ac->p = e.p;
+        ac->visit = e.visit;
+        ac->parent_state = parents[ki.first];
+        if (e.expanded) {
+            auto child = make_shared<LegacyState>();
+            child->game.move(Move<Gomoku>{ ki.second / BOARD_SIZE, ki.second % BOARD_SIZE });
+            child->ns = e.visit;
+            child->v = -e.v;
+            child->virtual_loss_cnt(0) = e.vl;
+            ac->child_state = [child]() { return child; };
+            ac->child_state.value();
+        }
+        parents[ki.first]->child_actions.value()[ki.second] = ac;
+    }
+
+    // edge lanes
+    vector<vector<EdgeLane>> lanes(N_PARENTS, vector<EdgeLane>(edge_lane_count(N_CHILDREN)));
+    for (int k = 0; k < N_PARENTS; k++) {
+        for (int i = 0; i < N_CHILDREN; i++) {
+            const EdgeSample& e = samples[k][i];
+            EdgeLane& lane = lanes[k][i >> 3];
+            lane.p[i & 7] = e.p;
+            lane.q[i & 7] = e.v;
+            lane.visit[i & 7] = e.visit;
+            lane.vl[i & 7] = e.vl;
+        }
+        pad_edge_lanes(lanes[k].data(), N_CHILDREN);
+    }
+
+    for (int k = 0; k < N_PARENTS; k++) {
+        float c = PUCT * sqrtf(float(parent_ns[k]));
+        if (legacy_select(parents[k].get(), 0) != puct_argmax(lanes[k].data(), N_CHILDREN, c, VIRTUAL_LOSS)) {
+            printf("warning: layouts disagree at parent %d\n", k);
+        }
+    }
+
+    auto pick = [](int i) { return (i * 97) % N_PARENTS; };
+    double t_legacy = time_per_step([&](int i) {
+        return legacy_select(parents[pick(i)].get(), 0);
+    }, steps);
+    double t_scalar = time_per_step([&](int i) {
+        int k = pick(i);
+        return puct_argmax_scalar(lanes[k].data(), N_CHILDREN, PUCT * sqrtf(float(parent_ns[k])), VIRTUAL_LOSS);
+    }, steps);
+    double t_vector = time_per_step([&](int i) {
+        int k = pick(i);
+        return puct_argmax(lanes[k].data(), N_CHILDREN, PUCT * sqrtf(float(parent_ns[k])), VIRTUAL_LOSS);
+    }, steps);
+
+    printf("%d-wide nodes, %d parents\n", N_CHILDREN, N_PARENTS);
+    printf("legacy : %7.1f ns/step\n", t_legacy * 1e9);
+    printf("scalar : %7.1f ns/step, %.1fx\n", t_scalar * 1e9, t_legacy / t_scalar);
+    printf("vector : %7.1f ns/step, %.1fx\n", t_vector * 1e9, t_legacy / t_vector);
+}
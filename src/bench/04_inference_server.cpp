@@ -0,0 +1,87 @@
+#include "bench.h"
+#include <maestro/search/search_graph.h>
+#include <maestro/game/game_gomoku.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/inference_server.h>
+#include <thread>
+#include <atomic>
+
+using namespace Maestro;
+
+namespace {
+    // cost model of a CPU network: a fixed overhead per call plus a per
+    // position cost, burnt on the calling thread
+    class CpuCostEvaluator final : public IEvaluator<Gomoku> {
+        SimplisticGomokuEvaluator _evaluator;
+        static void spin(chrono::microseconds t) {
+            auto end = chrono::steady_clock::now() + t;
+            while (chrono::steady_clock::now() < end) {}
+        }
+    public:
+        atomic<int> calls{ 0 };
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            calls++;
+            spin(chrono::microseconds(200 + 2));
+            return _evaluator.evaluate(game);
+        }
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override {
+            calls++;
+            spin(chrono::microseconds(200 + 2 * games.size()));
+            vector<Evaluation<Gomoku>> evals;
+            for (auto* g : games) {
+                evals.push_back(_evaluator.evaluate(*g));
+            }
+            return evals;
+        }
+    };
+
+    // plays the first moves of n_games games at once, all searches sharing eval
+    double run_games(shared_ptr<IEvaluator<Gomoku>> eval, int n_games, int n_moves, int n_sim) {
+        vector<thread> games;
+        atomic<int> sims{ 0 };
+        double start = bench_clock();
+        for (int i = 0; i < n_games; i++) {
+            games.emplace_back([&, i]() {
+                Gomoku g;
+                g.move(Move<Gomoku>{ 5 + i % 5, 5 + i / 5 % 5 });
+                MonteCarloGraphSearch<Gomoku>::Config c;
+                c.same_response = true;
+                MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+                for (int k = 0; k < n_moves && !search.get_game_snapshot().get_status().end; k++) {
+                    search.simulate(n_sim);
+                    search.move(search.pick_move(0));
+                }
+                sims += search.global_stat.sim_total;
+            });
+        }
+        for (auto& t : games) {
+            t.join();
+        }
+        return sims / (bench_clock() - start);
+    }
+}
+
+BENCH_CASE(inference_server) {
+    const int n_games = 32, n_moves = 3, n_sim = 300;
+    printf("%d games, %d moves of %d simulations each\n", n_games, n_moves, n_sim);
+
+    {
+        auto eval = make_shared<CpuCostEvaluator>();
+        double sps = run_games(eval, n_games, n_moves, n_sim);
+        printf("direct                 : sims/sec=%7.0f, calls=%d\n", sps, eval->calls.load());
+    }
+
+    pair<int, int> configs[] = { { 16, 500 }, { 64, 1000 }, { 256, 2000 }, { 256, 5000 }, { 1024, 10000 } };
+    for (auto& bl : configs) {
+        auto eval = make_shared<CpuCostEvaluator>();
+        InferenceServer<Gomoku>::Config c;
+        c.max_batch_size = bl.first;
+        c.max_latency = chrono::microseconds(bl.second);
+        auto server = make_shared<InferenceServer<Gomoku>>(eval, c);
+        double sps = run_games(server, n_games, n_moves, n_sim);
+        auto stat = server->stat();
+        printf("batch=%4d, latency=%5dus: sims/sec=%7.0f, calls=%d, mean batch=%6.1f, latency mean=%.2fms max=%.2fms\n",
+            bl.first, bl.second, sps, eval->calls.load(), stat.mean_batch_size(),
+            stat.mean_latency() * 1e3, stat.max_latency_seconds * 1e3);
+    }
+}
@@ -0,0 +1,47 @@
+#include "bench.h"
+#include <maestro/evaluator/eval_gomoku_nn.h>
+#include <cstdlib>
+#include <random>
+
+using namespace Maestro;
+
+// needs a compiled model, given as MAESTRO_NN_MODEL=<prefix>
+BENCH_CASE(nn_evaluator) {
+    const char* prefix = getenv("MAESTRO_NN_MODEL");
+    if (!prefix) {
+        printf("skipped, set MAESTRO_NN_MODEL to a model prefix\n");
+        return;
+    }
+    NNGomokuEvaluator eval(prefix);
+    printf("modules:");
+    for (int n : eval.batch_sizes()) printf(" %d", n);
+    printf("\n");
+
+    // positions of random games
+    minstd_rand rnd_eng(2020);
+    vector<Gomoku> positions;
+    while (positions.size() < 256) {
+        Gomoku g;
+        int n_moves = 4 + rnd_eng() % 40;
+        for (int i = 0; i < n_moves && !g.get_status().end; i++) {
+            auto moves = g.get_all_legal_moves();
+            g.move(moves[rnd_eng() % moves.size()]);
+        }
+        if (!g.get_status().end) positions.push_back(g);
+    }
+
+    for (int batch = 1; batch <= 256; batch *= 2) {
+        vector<Gomoku*> games;
+        for (int i = 0; i < batch; i++) {
+            games.push_back(&positions[i]);
+        }
+        eval.evaluate(games); // warm up
+        int reps = max(3, 512 / batch);
+        double start = bench_clock();
+        for (int r = 0; r < reps; r++) {
+            eval.evaluate(games);
+        }
+        double t = (bench_clock() - start) / reps;
+        printf("batch=%3d: latency=%8.3fms, throughput=%9.0f positions/sec\n", batch, t * 1e3, batch / t);
+    }
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include <maestro/evaluator/eval_gomoku_symmetric.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <random>
+
+using namespace Maestro;
+
+namespace {
+    vector<Gomoku> random_positions(int n, int n_moves) {
+        minstd_rand rnd_eng(1234);
+        vector<Gomoku> positions;
+        while (int(positions.size()) < n) {
+            Gomoku g;
+            for (int i = 0; i < n_moves && !g.get_status().end; i++) {
+                auto moves = g.get_all_legal_moves();
+                g.move(moves[rnd_eng() % moves.size()]);
+            }
+            if (!g.get_status().end) positions.push_back(g);
+        }
+        return positions;
+    }
+}
+
+BENCH_CASE(symmetry_transform) {
+    auto positions = random_positions(1000, 60);
+    const int reps = 100;
+    size_t check = 0;
+
+    // per cell, as a transform would be written without the bitboard kernels
+    double start = bench_clock();
+    for (int r = 0; r < reps; r++) {
+        for (auto& g : positions) {
+            int sym = (r + int(check)) & 7;
+            Gomoku::HalfBoard b, w;
+            for (int i = 0; i < BOARD_SIZE; i++) {
+                for (int j = 0; j < BOARD_SIZE; j++) {
+                    Move<Gomoku> m = Symmetry<Gomoku>::apply(Move<Gomoku>{ i, j }, sym);
+                    b.set(m, g.black.get(i, j));
+                    w.set(m, g.white.get(i, j));
+                }
+            }
+            check += b.bits().word(1) + w.bits().word(2);
+        }
+    }
+    double per_cell = (bench_clock() - start) / reps / positions.size();
+
+    start = bench_clock();
+    for (int r = 0; r < reps; r++) {
+        for (auto& g : positions) {
+            int sym = (r + int(check)) & 7;
+            check += g.black.transformed(sym).bits().word(1) + g.white.transformed(sym).bits().word(2);
+        }
+    }
+    double bitboard = (bench_clock() - start) / reps / positions.size();
+
+    start = bench_clock();
+    for (int r = 0; r < reps; r++) {
+        for (auto& g : positions) {
+            check += g.transformed((r + int(check)) & 7).get_hash();
+        }
+    }
+    double game = (bench_clock() - start) / reps / positions.size();
+
+    start = bench_clock();
+    for (int r = 0; r < reps; r++) {
+        for (auto& g : positions) {
+            check += Symmetry<Gomoku>::canonical(g);
+        }
+    }
+    double canonical = (bench_clock() - start) / reps / positions.size();
+
+    printf("board pair per cell=%.0fns, bitboard=%.0fns, game with hash=%.0fns, canonical=%.0fns (%zu)\n",
+        per_cell * 1e9, bitboard * 1e9, game * 1e9, canonical * 1e9, check & 1);
+}
+
+BENCH_CASE(symmetric_evaluator) {
+    auto positions = random_positions(256, 30);
+    vector<Gomoku*> batch;
+    for (auto& g : positions) {
+        batch.push_back(&g);
+    }
+    shared_ptr<IEvaluator<Gomoku>> eval = make_shared<SimplisticGomokuEvaluator>();
+    const int reps = 20;
+
+    double start = bench_clock();
+    for (int r = 0; r < reps; r++) {
+        eval->evaluate(batch);
+    }
+    double direct = (bench_clock() - start) / reps / batch.size();
+    printf("direct: %.2fus per position\n", direct * 1e6);
+
+    for (int k : { 1, 2, 8 }) {
+        SymmetricGomokuEvaluator sym_eval(eval, k);
+        start = bench_clock();
+        for (int r = 0; r < reps; r++) {
+            sym_eval.evaluate(batch);
+        }
+        double t = (bench_clock() - start) / reps / batch.size();
+        printf("symmetries=%d: %.2fus per position, overhead beyond %d evaluations=%.2fus\n",
+            k, t * 1e6, k, (t - k * direct) * 1e6);
+    }
+}
@@ -0,0 +1,60 @@
+#include "bench.h"
+#include <maestro/search/search_tree.h>
+#include <maestro/search/search_tree_compact.h>
+#include <maestro/game/game_gomoku.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+
+using namespace Maestro;
+
+namespace {
+    // simulates n_sim and reports node creation rate and node memory
+    template<typename TSearch>
+    void measure(const char* name, TSearch& search, int n_sim) {
+        double start = bench_clock();
+        search.simulate(n_sim);
+        double t = bench_clock() - start;
+        size_t nodes = search.node_count();
+        printf("%-8s sims=%6d: sims/sec=%8.0f, nodes=%8zu, nodes/sec=%10.0f, bytes/node=%5.0f, mem=%7.1fMB\n",
+            name, n_sim, n_sim / t, nodes, nodes / t, double(search.memory_bytes()) / nodes,
+            search.memory_bytes() / 1048576.0);
+    }
+
+    // plays up to n_moves along the most visited child, n_sim simulations each
+    template<typename TSearch>
+    void measure_moves(const char* name, TSearch& search, int n_sim, int n_moves) {
+        double t_move = 0;
+        int i = 0;
+        for (; i < n_moves && !search.get_game_snapshot().get_status().end; i++) {
+            search.simulate(n_sim);
+            auto m = search.pick_move(0);
+            double start = bench_clock();
+            search.move(m);
+            t_move += bench_clock() - start;
+        }
+        printf("%-8s moves=%d: move mean=%.3fms, nodes kept=%zu\n", name, i, t_move / max(1, i) * 1e3, search.node_count());
+    }
+}
+
+BENCH_CASE(tree_layout) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+    g.move(Move<Gomoku>{ 7, 8 });
+    g.move(Move<Gomoku>{ 8, 8 });
+
+    for (int n_sim : { 1000, 10000, 50000 }) {
+        MonteCarloTreeSearch<Gomoku> heap(&g, 2, eval.get());
+        measure("heap", heap, n_sim);
+        CompactMonteCarloTreeSearch<Gomoku>::Config c;
+        c.same_response = true;
+        CompactMonteCarloTreeSearch<Gomoku> compact(eval, g, c);
+        measure("compact", compact, n_sim);
+    }
+
+    MonteCarloTreeSearch<Gomoku> heap(&g, 2, eval.get());
+    measure_moves("heap", heap, 5000, 10);
+    CompactMonteCarloTreeSearch<Gomoku>::Config c;
+    c.same_response = true;
+    CompactMonteCarloTreeSearch<Gomoku> compact(eval, g, c);
+    measure_moves("compact", compact, 5000, 10);
+}
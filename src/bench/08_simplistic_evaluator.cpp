@@ -0,0 +1,89 @@
+#include "bench.h"
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <random>
+#include <cmath>
+
+using namespace Maestro;
+
+namespace {
+    // the per-cell scan SimplisticGomokuEvaluator used before the bitboard
+    // one, with its jitter drawn from a generator seeded by the hash
+    Evaluation<Gomoku> reference_evaluate(const Gomoku& game) {
+        minstd_rand rnd_eng;
+        rnd_eng.seed(game.get_hash());
+        uniform_real_distribution<float> dist(0, 1E-3);
+
+        vector<MovePrior<Gomoku>> p;
+        p.reserve(10);
+        float sum = 0;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                Move<Gomoku> m{ r, c };
+                if (!game.is_legal_move_unchecked(m)) continue;
+                bool found = false;
+                for (int dr = -1; dr <= 1 && !found; dr++) {
+                    for (int dc = -1; dc <= 1 && !found; dc++) {
+                        found = game.black.safe_get(r + dr, c + dc) || game.white.safe_get(r + dr, c + dc);
+                    }
+                }
+                if (found) {
+                    float prior = 1 + dist(rnd_eng);
+                    sum += prior;
+                    p.push_back(MovePrior<Gomoku>{ m, prior });
+                }
+            }
+        }
+        if (p.size() == 0) {
+            sum += 1;
+            p.push_back(MovePrior<Gomoku>{ Move<Gomoku>{ 7, 7 }, 1 });
+        }
+        for (MovePrior<Gomoku>& mp : p) {
+            mp.p = mp.p / sum;
+        }
+        return Evaluation<Gomoku>{ move(p), 0 };
+    }
+}
+
+BENCH_CASE(simplistic_evaluator) {
+    SimplisticGomokuEvaluator eval;
+    minstd_rand rnd_eng(4321);
+    for (int n_moves : { 2, 20, 60, 120 }) {
+        vector<Gomoku> positions;
+        while (positions.size() < 1000) {
+            Gomoku g;
+            for (int i = 0; i < n_moves && !g.get_status().end; i++) {
+                auto moves = g.get_all_legal_moves();
+                g.move(moves[rnd_eng() % moves.size()]);
+            }
+            if (!g.get_status().end) positions.push_back(g);
+        }
+
+        int mismatches = 0;
+        size_t n_priors = 0;
+        for (auto& g : positions) {
+            auto a = eval.evaluate(g), b = reference_evaluate(g);
+            // the tie-breaking jitter differs, the moves and their order do not
+            bool same = a.p.size() == b.p.size();
+            for (int i = 0; same && i < int(a.p.size()); i++) {
+                same = a.p[i].move == b.p[i].move && fabs(a.p[i].p - b.p[i].p) < 2e-3f * b.p[i].p;
+            }
+            mismatches += !same;
+            n_priors += a.p.size();
+        }
+
+        const int reps = 50;
+        float check = 0;
+        double start = bench_clock();
+        for (int r = 0; r < reps; r++) {
+            for (auto& g : positions) check += reference_evaluate(g).p[0].p;
+        }
+        double t_ref = (bench_clock() - start) / (reps * positions.size());
+        start = bench_clock();
+        for (int r = 0; r < reps; r++) {
+            for (auto& g : positions) check += eval.evaluate(g).p[0].p;
+        }
+        double t = (bench_clock() - start) / (reps * positions.size());
+        printf("stones=%3d: moves=%5.1f, per-cell=%7.0fns, bitboard=%6.0fns, speedup=%5.1fx, mismatches=%d (%g)\n",
+            n_moves, double(n_priors) / positions.size(), t_ref * 1e9, t * 1e9, t_ref / t, mismatches, check);
+    }
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/search/search_tree_compact.h>
+#include <maestro/play/round.h>
+#include <random>
+
+using namespace Maestro;
+
+namespace {
+    shared_ptr<IPlayer<Gomoku>> make_player(shared_ptr<IEvaluator<Gomoku>> eval, const Gomoku& opening, int n_sim) {
+        CompactMonteCarloTreeSearch<Gomoku>::Config c;
+        c.same_response = true;
+        c.dirichlet_noise = false;
+        auto search = make_shared<CompactMonteCarloTreeSearch<Gomoku>>(eval, opening, c);
+        return make_shared<MonteCarloAIPlayer<Gomoku>>(search, n_sim);
+    }
+
+    // three random stones near the centre
+    vector<Gomoku> openings(int n, uint32_t seed) {
+        minstd_rand rnd_eng(seed);
+        vector<Gomoku> r;
+        while (int(r.size()) < n) {
+            Gomoku g;
+            while ((g.black.bits() | g.white.bits()).count() < 3) {
+                Move<Gomoku> m{ 5 + int(rnd_eng() % 5), 5 + int(rnd_eng() % 5) };
+                if (g.is_legal_move(m)) g.move(m);
+            }
+            r.push_back(g);
+        }
+        return r;
+    }
+
+    // score of a with a_sims against b with b_sims over the openings, each
+    // played with either side to move first; wins count 1, draws 1/2
+    double play(shared_ptr<IEvaluator<Gomoku>> a, int a_sims, shared_ptr<IEvaluator<Gomoku>> b, int b_sims,
+        const vector<Gomoku>& games, double& seconds_per_game) {
+        double score = 0;
+        double start = bench_clock();
+        for (const Gomoku& g : games) {
+            for (int a_first = 0; a_first < 2; a_first++) {
+                auto pa = make_player(a, g, a_sims), pb = make_player(b, g, b_sims);
+                // the openings leave white to move, so A plays white
+                Round<Gomoku> r(g, a_first ? pb : pa, a_first ? pa : pb);
+                r.step_to_end();
+                Color winner = r.game().get_status().winner;
+                Color a_color = a_first ? Color::B : Color::A;
+                score += winner == Color::None ? 0.5 : winner == a_color ? 1 : 0;
+            }
+        }
+        seconds_per_game = (bench_clock() - start) / (2 * games.size());
+        return score / (2 * games.size());
+    }
+}
+
+BENCH_CASE(pattern_evaluator) {
+    auto pattern = make_shared<PatternGomokuEvaluator>();
+    auto simplistic = make_shared<SimplisticGomokuEvaluator>();
+
+    double start = bench_clock();
+    PatternGomokuEvaluator::threat(0, 0);
+    printf("table build: %.1fms\n", (bench_clock() - start) * 1e3);
+
+    // cost of one evaluation in the middle game
+    vector<Gomoku> positions;
+    minstd_rand rnd_eng(4321);
+    while (positions.size() < 1000) {
+        Gomoku g;
+        for (int i = 0; i < 40 && !g.get_status().end; i++) {
+            auto moves = g.get_all_legal_moves();
+            g.move(moves[rnd_eng() % moves.size()]);
+        }
+        if (!g.get_status().end) positions.push_back(g);
+    }
+    for (auto eval : { shared_ptr<IEvaluator<Gomoku>>(simplistic), shared_ptr<IEvaluator<Gomoku>>(pattern) }) {
+        const int reps = 20;
+        float check = 0;
+        start = bench_clock();
+        for (int r = 0; r < reps; r++) {
+            for (auto& g : positions) check += eval->evaluate(g).v;
+        }
+        printf("%-10s %6.0fns per evaluation (%g)\n", eval == pattern ? "pattern" : "simplistic",
+            (bench_clock() - start) / (reps * positions.size()) * 1e9, check);
+    }
+
+    // pattern against simplistic at equal simulations, and against
+    // simplistic given eight times as many
+    auto games = openings(8, 97);
+    for (int n_sim : { 50, 200, 800 }) {
+        double t1, t8;
+        double equal = play(pattern, n_sim, simplistic, n_sim, games, t1);
+        double eight = play(pattern, n_sim, simplistic, 8 * n_sim, games, t8);
+        printf("sims=%4d: pattern score vs simplistic=%.2f (%.2fs/game), vs simplistic x8=%.2f (%.2fs/game)\n",
+            n_sim, equal, t1, eight, t8);
+    }
+    // searches on the pattern evaluator still gain from more simulations
+    for (int n_sim : { 50, 200 }) {
+        double t;
+        double score = play(pattern, 8 * n_sim, pattern, n_sim, games, t);
+        printf("sims=%4d: pattern x8 score vs pattern=%.2f (%.2fs/game)\n", n_sim, score, t);
+    }
+}
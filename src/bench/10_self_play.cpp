@@ -0,0 +1,41 @@
+#include "bench.h"
+#include <maestro/play/self_play.h>
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <thread>
+#include <cstdio>
+
+using namespace Maestro;
+
+BENCH_CASE(self_play) {
+    auto eval = make_shared<PatternGomokuEvaluator>();
+    int max_threads = max(1, int(thread::hardware_concurrency()));
+    for (int n_sim : { 100, 400 }) {
+        for (int n = 1; n <= max_threads; n *= 2) {
+            SelfPlay::Config c;
+            c.n_threads = n;
+            c.n_sim = n_sim;
+            SelfPlay self_play(eval, "bench_self_play", c);
+            for (int t = 0; t < n; t++) {
+                remove(self_play.shard_path(t).c_str());
+            }
+            SelfPlay::Stat stat = self_play.play(4 * n);
+            printf("sims=%3d, threads=%2d: ", n_sim, n);
+            stat.print();
+
+            // read back as a trainer would, in batches
+            double start = bench_clock();
+            int64_t n_read = 0;
+            vector<GomokuRecord> batch(256);
+            for (int t = 0; t < n; t++) {
+                TrainingDataReader reader(self_play.shard_path(t));
+                while (size_t k = reader.read(batch.data(), batch.size())) {
+                    n_read += k;
+                }
+                remove(self_play.shard_path(t).c_str());
+            }
+            double t = bench_clock() - start;
+            printf("  read %lld records, %.0f records/sec, %.0fMB/sec\n", (long long)n_read, n_read / t,
+                n_read * sizeof(GomokuRecord) / t / 1048576);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "bench.h"
+#include "corpus.h"
+#include <maestro/search/search_graph.h>
+#include <maestro/search/search_tree.h>
+#include <maestro/search/search_tree_compact.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <algorithm>
+#include <atomic>
+
+using namespace Maestro;
+
+namespace {
+    const int SUITE_SIMS = 4000;
+    // simulations timed together for one latency sample
+    const int SIM_CHUNK = 32;
+    const int EVAL_CALLS = 2000;
+    const int MOVE_REPLAYS = 2000;
+
+    // counts the positions evaluated through it, batched or not
+    class CountingEvaluator final : public IEvaluator<Gomoku> {
+        shared_ptr<IEvaluator<Gomoku>> _evaluator;
+    public:
+        atomic<int64_t> count{ 0 };
+        explicit CountingEvaluator(shared_ptr<IEvaluator<Gomoku>> evaluator) : _evaluator(std::move(evaluator)) {}
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            count++;
+            return _evaluator->evaluate(game);
+        }
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override {
+            count += games.size();
+            return _evaluator->evaluate(games);
+        }
+    };
+
+    struct Latency {
+        double p50 = 0, p90 = 0, p99 = 0, max = 0;
+        explicit Latency(vector<double> samples) {
+            if (samples.empty()) return;
+            sort(samples.begin(), samples.end());
+            auto at = [&samples](double q) { return samples[min(samples.size() - 1, size_t(q * samples.size()))]; };
+            p50 = at(0.5);
+            p90 = at(0.9);
+            p99 = at(0.99);
+            max = samples.back();
+        }
+        // in microseconds
+        void write(string& json, const char* key) const {
+            appendf(json, "\"%s\":{\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}", key, p50 * 1e6, p90 * 1e6, p99 * 1e6, max * 1e6);
+        }
+    };
+
+    // runs SUITE_SIMS simulations in chunks, timing each chunk
+    template<typename TSearch>
+    void run_search(const char* engine, const BenchPosition& pos, TSearch& search, CountingEvaluator& eval,
+        function<size_t()> engine_bytes, string& json) {
+        vector<double> per_sim;
+        int64_t evals_before = eval.count;
+        double start = bench_clock();
+        for (int done = 0; done < SUITE_SIMS; done += SIM_CHUNK) {
+            double t = bench_clock();
+            search.simulate(SIM_CHUNK);
+            per_sim.push_back((bench_clock() - t) / SIM_CHUNK);
+        }
+        double seconds = bench_clock() - start;
+        int64_t evals = eval.count - evals_before;
+        Latency latency(per_sim);
+
+        printf("%-8s %-20s sims/sec=%9.0f, evals/sec=%9.0f, p50=%7.2fus, p99=%7.2fus, mem=%7.2fMB\n",
+            engine, pos.name.c_str(), SUITE_SIMS / seconds, evals / seconds, latency.p50 * 1e6, latency.p99 * 1e6,
+            engine_bytes() / 1048576.0);
+        appendf(json, "%s{\"engine\":\"%s\",\"position\":\"%s\",\"sims\":%d,\"seconds\":%.6f,"
+            "\"sims_per_sec\":%.1f,\"evals\":%lld,\"evals_per_sec\":%.1f,",
+            json.back() == '[' ? "" : ",", engine, pos.name.c_str(), SUITE_SIMS, seconds, SUITE_SIMS / seconds,
+            (long long)evals, evals / seconds);
+        latency.write(json, "sim_latency_us");
+        appendf(json, ",\"engine_bytes\":%zu,\"peak_rss_bytes\":%zu}", engine_bytes(), peak_rss_bytes());
+    }
+}
+
+// Every engine on every corpus position with fixed seeds, then the
+// evaluators and Gomoku::move alone. Human-readable lines go to stdout,
+// one JSON line to bench_json. Peak memory is that of the process,
+// so run the suite on its own to compare it across runs.
+BENCH_CASE(search_suite) {
+    auto& corpus = bench_corpus();
+    string json;
+    appendf(json, "{\"suite\":\"search\",\"positions\":[");
+    for (int i = 0; i < int(corpus.size()); i++) {
+        appendf(json, "%s{\"name\":\"%s\",\"stones\":%zu,\"zobrist\":\"%016llx\"}", i ? "," : "",
+            corpus[i].name.c_str(), corpus[i].moves.size(), (unsigned long long)corpus[i].game().get_zobrist());
+    }
+    appendf(json, "],\"search\":[");
+
+    for (auto& pos : corpus) {
+        Gomoku g = pos.game();
+        {
+            CountingEvaluator eval(make_shared<SimplisticGomokuEvaluator>());
+            auto shared = shared_ptr<IEvaluator<Gomoku>>(shared_ptr<IEvaluator<Gomoku>>(), &eval);
+            MonteCarloGraphSearch<Gomoku>::Config c;
+            c.same_response = true;
+            MonteCarloGraphSearch<Gomoku> search(shared, g, c);
+            run_search("graph", pos, search, eval, [&search]() {
+                return search.global_stat.mem_arena + search.global_stat.mem_tt;
+            }, json);
+        }
+        {
+            CountingEvaluator eval(make_shared<SimplisticGomokuEvaluator>());
+            auto shared = shared_ptr<IEvaluator<Gomoku>>(shared_ptr<IEvaluator<Gomoku>>(), &eval);
+            CompactMonteCarloTreeSearch<Gomoku>::Config c;
+            c.same_response = true;
+            c.dirichlet_noise = false;
+            CompactMonteCarloTreeSearch<Gomoku> search(shared, g, c);
+            run_search("compact", pos, search, eval, [&search]() { return search.memory_bytes(); }, json);
+        }
+        {
+            CountingEvaluator eval(make_shared<SimplisticGomokuEvaluator>());
+            MonteCarloTreeSearch<Gomoku> search(&g, 2, &eval);
+            run_search("heap", pos, search, eval, [&search]() { return search.memory_bytes(); }, json);
+        }
+    }
+    appendf(json, "],\"evaluators\":[");
+
+    vector<pair<const char*, shared_ptr<IEvaluator<Gomoku>>>> evaluators = {
+        { "simplistic", make_shared<SimplisticGomokuEvaluator>() },
+        { "pattern", make_shared<PatternGomokuEvaluator>() },
+    };
+    for (auto& e : evaluators) {
+        e.second->evaluate(Gomoku());
+        for (auto& pos : corpus) {
+            Gomoku g = pos.game();
+            vector<double> samples;
+            float check = 0;
+            double start = bench_clock();
+            for (int i = 0; i < EVAL_CALLS; i++) {
+                double t = bench_clock();
+                check += e.second->evaluate(g).v;
+                samples.push_back(bench_clock() - t);
+            }
+            double seconds = bench_clock() - start;
+            Latency latency(samples);
+            printf("%-10s %-20s evals/sec=%9.0f, p50=%7.2fus, p99=%7.2fus (%g)\n",
+                e.first, pos.name.c_str(), EVAL_CALLS / seconds, latency.p50 * 1e6, latency.p99 * 1e6, check);
+            appendf(json, "%s{\"evaluator\":\"%s\",\"position\":\"%s\",\"evals_per_sec\":%.1f,",
+                json.back() == '[' ? "" : ",", e.first, pos.name.c_str(), EVAL_CALLS / seconds);
+            latency.write(json, "latency_us");
+            appendf(json, "}");
+        }
+    }
+
+    // replays every position, most of the cost in the win check of move()
+    int64_t n_moves = 0;
+    int check = 0;
+    double start = bench_clock();
+    for (int r = 0; r < MOVE_REPLAYS; r++) {
+        for (auto& pos : corpus) {
+            check += pos.game().get_status().end;
+            n_moves += pos.moves.size();
+        }
+    }
+    double seconds = bench_clock() - start;
+    printf("gomoku move: moves/sec=%.0f (%d)\n", n_moves / seconds, check);
+    appendf(json, "],\"gomoku_move\":{\"moves\":%lld,\"moves_per_sec\":%.1f},\"peak_rss_bytes\":%zu}",
+        (long long)n_moves, n_moves / seconds, peak_rss_bytes());
+    fprintf(bench_json, "%s\n", json.c_str());
+    fflush(bench_json);
+}
@@ -0,0 +1,166 @@
+#include "bench.h"
+#include "corpus.h"
+#include "micro.h"
+#include <maestro/game/game_gomoku.h>
+#include <maestro/util/lazy.h>
+#include <maestro/util/expirable.h>
+#include <maestro/util/nullable.h>
+#include <memory>
+
+using namespace Maestro;
+
+namespace {
+    const int N_SLOTS = 1024;
+
+    // cycles through items, so that a call cannot be hoisted out of the loop
+    template<typename T>
+    class Cycle {
+        const vector<T>& _items;
+        size_t _i = 0;
+    public:
+        explicit Cycle(const vector<T>& items) : _items(items) {}
+        const T& next() {
+            const T& item = _items[_i];
+            if (++_i == _items.size()) _i = 0;
+            return item;
+        }
+    };
+}
+
+// The Gomoku primitives over the positions of the corpus; move is timed
+// from every position along the corpus lines, copy being its baseline.
+BENCH_CASE(micro_gomoku) {
+    vector<Gomoku> positions;
+    vector<pair<Gomoku, Move<Gomoku>>> steps;
+    vector<pair<Gomoku, Gomoku>> transfers;
+    for (auto& pos : bench_corpus()) {
+        Gomoku g;
+        Gomoku end = pos.game();
+        for (auto m : pos.moves) {
+            steps.push_back({ g, m });
+            transfers.push_back({ g, end });
+            g.move(m);
+        }
+        positions.push_back(end);
+    }
+
+    MicroSuite suite("micro_gomoku");
+    {
+        Cycle<pair<Gomoku, Move<Gomoku>>> c(steps);
+        suite.run("Gomoku copy", [&c]() {
+            Gomoku g = c.next().first;
+            bench_keep(g);
+            return g.get_color();
+        });
+    }
+    {
+        Cycle<pair<Gomoku, Move<Gomoku>>> c(steps);
+        suite.run("Gomoku::move", [&c]() {
+            auto& s = c.next();
+            Gomoku g = s.first;
+            g.move(s.second);
+            return g.get_status().end;
+        });
+    }
+    {
+        Cycle<Gomoku> c(positions);
+        suite.run("Gomoku::check_status", [&c]() { return c.next().check_status().end; });
+    }
+    {
+        Cycle<Gomoku> c(positions);
+        suite.run("Gomoku::get_hash", [&c]() { return c.next().get_hash(); });
+    }
+    {
+        Cycle<Gomoku> c(positions);
+        suite.run("Gomoku::get_all_legal_moves", [&c]() { return c.next().get_all_legal_moves().size(); });
+    }
+    {
+        Cycle<pair<Gomoku, Gomoku>> c(transfers);
+        suite.run("Gomoku::could_transfer_to", [&c]() {
+            auto& t = c.next();
+            return t.first.could_transfer_to(t.second);
+        });
+    }
+    {
+        Cycle<Gomoku> c(positions);
+        suite.run("Gomoku::to_string", [&c]() { return c.next().to_string().size(); });
+    }
+}
+
+// The wrappers the search nodes keep their children and per-simulation
+// values in, each over N_SLOTS instances as a search walks many nodes.
+BENCH_CASE(micro_util) {
+    MicroSuite suite("micro_util");
+    {
+        vector<Lazy<int>> lazy;
+        for (int i = 0; i < N_SLOTS; i++) {
+            lazy.emplace_back([i]() { return i; });
+            lazy.back().value();
+        }
+        int i = 0;
+        suite.run("Lazy::value initialized", [&]() {
+            int v = lazy[i].value();
+            i = (i + 1) % N_SLOTS;
+            return v;
+        });
+    }
+    {
+        int i = 0;
+        suite.run("Lazy construct + value", [&i]() {
+            Lazy<int> lazy([&i]() { return i; });
+            i++;
+            return lazy.value();
+        });
+    }
+    {
+        vector<Expirable<float>> expirable(N_SLOTS);
+        int i = 0;
+        suite.run("Expirable::value same ts", [&]() {
+            float& v = expirable[i](1);
+            v += 1;
+            i = (i + 1) % N_SLOTS;
+            return v;
+        });
+    }
+    {
+        vector<Expirable<float>> expirable(N_SLOTS);
+        int i = 0, ts = 0;
+        suite.run("Expirable::value new ts", [&]() {
+            float& v = expirable[i](ts++);
+            v += 1;
+            i = (i + 1) % N_SLOTS;
+            return v;
+        });
+    }
+    {
+        vector<Nullable<int>> nullable(N_SLOTS);
+        for (int i = 0; i < N_SLOTS; i += 2) nullable[i] = i;
+        int i = 0;
+        suite.run("Nullable check + value", [&]() {
+            int v = nullable[i] ? nullable[i].value() : -1;
+            i = (i + 1) % N_SLOTS;
+            return v;
+        });
+    }
+    {
+        vector<Nullable<shared_ptr<int>>> nullable(N_SLOTS);
+        for (int i = 0; i < N_SLOTS; i++) nullable[i] = make_shared<int>(i);
+        int i = 0;
+        suite.run("Nullable<shared_ptr> copy", [&]() {
+            Nullable<shared_ptr<int>> copy(nullable[i]);
+            i = (i + 1) % N_SLOTS;
+            return copy.value().get();
+        });
+    }
+    {
+        vector<Nullable<shared_ptr<int>>> nullable(N_SLOTS);
+        for (int i = 0; i < N_SLOTS; i++) nullable[i] = make_shared<int>(i);
+        int i = 0;
+        suite.run("Nullable<shared_ptr> move", [&]() {
+            Nullable<shared_ptr<int>> moved(std::move(nullable[i]));
+            nullable[i] = std::move(moved);
+            i = (i + 1) % N_SLOTS;
+            return nullable[i].null();
+        });
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdarg>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+extern vector<pair<string, void(*)()>> bench_cases;
+// where cases write machine-readable results, one JSON object per line:
+// the file given by --json, or stdout
+extern FILE* bench_json;
+
+// wall clock in seconds since the first call
+inline double bench_clock() {
+    static auto start = chrono::steady_clock::now();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// appends printf-formatted text to out
+inline void appendf(string& out, const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    out.append(buf, min<size_t>(max(n, 0), sizeof(buf) - 1));
+}
+
+// peak resident memory of the process so far, in bytes
+inline size_t peak_rss_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize;
+#else
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return size_t(ru.ru_maxrss) * 1024;
+#endif
+}
+
+#define BENCH_CASE(name) void name(); static auto b_##name = bench_cases.insert(bench_cases.end(), pair<string, void(*)()>(#name, name)); void name()
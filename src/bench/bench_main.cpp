@@ -0,0 +1,33 @@
+#include "bench.h"
+
+using namespace std;
+vector<pair<string, void(*)()>> bench_cases;
+FILE* bench_json = stdout;
+
+// usage: Bench [filter] [--json path]
+// runs every case whose name contains the filter
+int main(int argc, char** argv) {
+    string filter;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--json" && i + 1 < argc) {
+            bench_json = fopen(argv[++i], "w");
+            if (!bench_json) {
+                cerr << "cannot open " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else {
+            filter = argv[i];
+        }
+    }
+
+    for (auto& p : bench_cases) {
+        if (p.first.find(filter) == string::npos) continue;
+        cout << "[" << p.first << "]" << endl;
+        double start = bench_clock();
+        p.second();
+        cout << "[" << p.first << "] done in " << bench_clock() - start << "s" << endl;
+    }
+    if (bench_json != stdout) fclose(bench_json);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "bench.h"
+#include <maestro/game/game_gomoku.h>
+#include <random>
+
+// Fixed Gomoku positions for benchmarks: openings, tactical positions
+// with threats on the board, and positions further on with more stones.
+// Every position is a list of moves from the empty board, so it also
+// replays Gomoku::move. None of them is over.
+struct BenchPosition {
+    string name;
+    vector<Maestro::Move<Maestro::Gomoku>> moves;
+
+    Maestro::Gomoku game() const {
+        Maestro::Gomoku g;
+        for (auto m : moves) g.move(m);
+        return g;
+    }
+};
+
+namespace bench_corpus_detail {
+    using namespace Maestro;
+
+    // n moves drawn with a fixed seed among the empty cells within
+    // distance d of a stone, or all of them when d is 0, never ending the game
+    inline vector<Move<Gomoku>> random_moves(uint32_t seed, int n, int d) {
+        minstd_rand rnd_eng(seed);
+        Gomoku g;
+        vector<Move<Gomoku>> moves;
+        g.move(Move<Gomoku>{ 7, 7 });
+        moves.push_back(Move<Gomoku>{ 7, 7 });
+        while (int(moves.size()) < n) {
+            Bits256 cells = d > 0 ? g.neighbourhood(d) : g.empty_cells();
+            vector<Move<Gomoku>> safe;
+            cells.for_each([&](int i) {
+                Gomoku h = g;
+                h.move(Gomoku::cell_move(i));
+                if (!h.get_status().end) safe.push_back(Gomoku::cell_move(i));
+            });
+            if (safe.empty()) break;
+            Move<Gomoku> m = safe[rnd_eng() % safe.size()];
+            g.move(m);
+            moves.push_back(m);
+        }
+        return moves;
+    }
+}
+
+inline const vector<BenchPosition>& bench_corpus() {
+    static const vector<BenchPosition> corpus = {
+        { "opening_empty", {} },
+        { "opening_center", { { 7, 7 }, { 7, 8 }, { 8, 8 } } },
+        // both sides have an open three, black to move
+        { "tactic_open_threes", { { 7, 7 }, { 6, 8 }, { 8, 8 }, { 6, 6 }, { 9, 9 }, { 6, 7 } } },
+        // black has a four, white must block at (7, 7)
+        { "tactic_four", { { 7, 3 }, { 0, 0 }, { 7, 4 }, { 0, 2 }, { 7, 5 }, { 7, 2 }, { 7, 6 } } },
+        // black to move can make two open threes at once at (7, 6)
+        { "tactic_fork", { { 7, 7 }, { 0, 0 }, { 7, 8 }, { 0, 14 }, { 8, 6 }, { 14, 0 }, { 9, 6 }, { 14, 14 } } },
+        { "midgame_40", bench_corpus_detail::random_moves(2024, 40, 1) },
+        { "endgame_180", bench_corpus_detail::random_moves(2025, 180, 0) },
+    };
+    return corpus;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "bench.h"
+#include <algorithm>
+#include <cstdint>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC
+#endif
+
+// time-stamp counter ticks, or steady clock nanoseconds where there is no
+// counter; the ticks run at a fixed rate, which is close to but not always
+// the rate of the core clock
+inline uint64_t bench_cycles() {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// keeps the compiler from dropping the computation of value
+template<typename T>
+inline void bench_keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#endif
+}
+
+struct MicroConfig {
+    int warmup = 3;
+    int repetitions = 15;
+    // calls of the function per repetition
+    int calls = 10000;
+};
+
+// Times small functions: after the warmup repetitions, each repetition
+// makes config.calls calls and gives one sample of time and cycles per
+// operation. The min, median and max of the samples go to stdout and, once
+// the suite is destroyed, as one JSON line to bench_json. The functions
+// should vary their input from call to call so that nothing is hoisted
+// out of the loop.
+class MicroSuite {
+    string _name;
+    MicroConfig _config;
+    string _json;
+public:
+    explicit MicroSuite(string name) : MicroSuite(std::move(name), MicroConfig()) {}
+    MicroSuite(string name, MicroConfig config) : _name(std::move(name)), _config(config) {}
+
+    // f returns a value that is kept; ops_per_call is for a function that
+    // makes several operations per call
+    template<typename F>
+    void run(const char* name, F f, int ops_per_call = 1) {
+        vector<double> ns, cycles;
+        for (int r = 0; r < _config.warmup + _config.repetitions; r++) {
+            double start = bench_clock();
+            uint64_t c_start = bench_cycles();
+            for (int i = 0; i < _config.calls; i++) {
+                bench_keep(f());
+            }
+            uint64_t c = bench_cycles() - c_start;
+            double t = bench_clock() - start;
+            if (r < _config.warmup) continue;
+            double ops = double(_config.calls) * ops_per_call;
+            ns.push_back(t * 1e9 / ops);
+            cycles.push_back(c / ops);
+        }
+        sort(ns.begin(), ns.end());
+        sort(cycles.begin(), cycles.end());
+        auto median = [](const vector<double>& v) { return v[v.size() / 2]; };
+
+        printf("%-28s ns/op: min=%9.2f, median=%9.2f, max=%9.2f; cycles/op: min=%9.1f, median=%9.1f\n",
+            name, ns.front(), median(ns), ns.back(), cycles.front(), median(cycles));
+        appendf(_json, "%s{\"name\":\"%s\",\"ops\":%lld,\"ns_min\":%.3f,\"ns_median\":%.3f,\"ns_max\":%.3f,"
+            "\"cycles_min\":%.2f,\"cycles_median\":%.2f}", _json.empty() ? "" : ",", name,
+            (long long)_config.calls * ops_per_call * _config.repetitions,
+            ns.front(), median(ns), ns.back(), cycles.front(), median(cycles));
+    }
+
+    ~MicroSuite() {
+#ifdef BENCH_HAS_TSC
+        const char* counter = "tsc";
+#else
+        const char* counter = "ns";
+#endif
+        fprintf(bench_json, "{\"suite\":\"%s\",\"counter\":\"%s\",\"warmup\":%d,\"repetitions\":%d,\"benchmarks\":[%s]}\n",
+            _name.c_str(), counter, _config.warmup, _config.repetitions, _json.c_str());
+        fflush(bench_json);
+    }
+};
@@ -2,15 +2,50 @@
 #include <maestro/search/search_graph.h>
 #include <maestro/game/game_gomoku.h>
 #include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_gomoku_nn.h>
+#include <maestro/evaluator/eval_cache.h>
+#include <maestro/evaluator/inference_server.h>
 #include <maestro/play/match.h>
+#include <maestro/play/self_play.h>
 #include <maestro/util/common.h>
-#include <tvm/runtime/module.h>
+#include <thread>
 using namespace Maestro;
 using namespace std;
 
-int main() {
-    auto eval = make_shared<SimplisticGomokuEvaluator>();
-    // tvm::runtime::Module::LoadFromFile("");
+// the network runs one batch at a time, so the searches of all cores
+// share it through a server that merges their requests into large batches
+shared_ptr<IEvaluator<Gomoku>> nn_evaluator(const string& model_prefix) {
+    return make_shared<InferenceServer<Gomoku>>(make_shared<NNGomokuEvaluator>(model_prefix));
+}
+
+// self-play on every core, records appended to <out prefix>-<thread>.bin
+int self_play(shared_ptr<IEvaluator<Gomoku>> eval, const string& prefix, int n_games) {
+    SelfPlay::Config c;
+    c.n_threads = max(1, int(thread::hardware_concurrency()));
+    c.search.dirichlet_noise = true;
+    SelfPlay self_play(eval, prefix, c);
+    self_play.play(n_games).print();
+    return 0;
+}
+
+// usage: CLI [model prefix]
+//        CLI selfplay <out prefix> <games> [model prefix]
+// with a compiled model both players use the network, see NNGomokuEvaluator
+int main(int argc, char** argv) {
+    shared_ptr<IEvaluator<Gomoku>> eval = make_shared<SimplisticGomokuEvaluator>();
+    if (argc > 1 && string(argv[1]) == "selfplay") {
+        if (argc < 4) {
+            printf("usage: CLI selfplay <out prefix> <games> [model prefix]\n");
+            return 1;
+        }
+        if (argc > 4) {
+            eval = nn_evaluator(argv[4]);
+        }
+        return self_play(eval, argv[2], atoi(argv[3]));
+    }
+    if (argc > 1) {
+        eval = nn_evaluator(argv[1]);
+    }
     Gomoku g;
     //g.black.set(1, 1, true);
     //g.white.set(2, 2, true);
@@ -20,33 +55,43 @@ int main() {
 
     using Config = MonteCarloGraphSearch<Gomoku>::Config;
 
+    // both players use the same evaluator, so they share its results across all games
+    auto cache = make_shared<EvaluationCache<Gomoku>>(1 << 16);
+
+    // fresh searches every round on every core: keep their tables small
     Config c1 = Config();
+    c1.tt_capacity = 1 << 16;
+    c1.eval_cache = cache;
     c1.leaf_batch_count = 1;
     c1.enable_dag = true;
     Config c2 = Config();
+    c2.tt_capacity = 1 << 16;
+    c2.eval_cache = cache;
     c2.leaf_batch_count = 1;
     //c2.leaf_batch_count = 8;
     c2.enable_dag = false;
 
-    shared_ptr<MonteCarloGraphSearch<Gomoku>> ps1, ps2;
-
     auto p1_creator = [&]() {
-        ps1 = make_shared<MonteCarloGraphSearch<Gomoku>>(eval, g, c1);
-        return make_shared<MonteCarloAIPlayer<Gomoku>>(ps1, 1000);
+        return make_shared<MonteCarloAIPlayer<Gomoku>>(make_shared<MonteCarloGraphSearch<Gomoku>>(eval, g, c1), 1000);
     };
 
     auto p2_creator = [&]() {
-        ps2 = make_shared<MonteCarloGraphSearch<Gomoku>>(eval, g, c2);
-        return make_shared<MonteCarloAIPlayer<Gomoku>>(ps2, 1000);
+        return make_shared<MonteCarloAIPlayer<Gomoku>>(make_shared<MonteCarloGraphSearch<Gomoku>>(eval, g, c2), 1000);
     };
 
-    Match<Gomoku> match(100, p1_creator, p2_creator);
-    while (match.step()) {
-        printf("p1 stat:\n");
-        ps1->print_stat();
-        printf("p2 stat:\n");
-        ps2->print_stat();
-    }
+    // one round per core, the cache is shared by all of them; stops once
+    // p1 is known to be 20 Elo stronger than p2, or not, and streams the
+    // score after every round to stdout as JSON lines
+    Match<Gomoku>::Config mc;
+    mc.n_threads = max(1, int(thread::hardware_concurrency()));
+    mc.quiet = true;
+    Sprt::Config sc;
+    sc.elo0 = 0;
+    sc.elo1 = 20;
+    mc.sprt = make_shared<Sprt>(sc);
+    mc.json = stdout;
+    Match<Gomoku> match(100, p1_creator, p2_creator, mc);
+    match.step_to_end();
 
     //auto pa =
     //    make_unique<MonteCarloAIPlayer<Gomoku>>(make_unique<MonteCarloGraphSearch<Gomoku>>(eval, g, c1), 10000);
@@ -0,0 +1 @@
+#include <maestro/evaluator/eval_async.h>
\ No newline at end of file
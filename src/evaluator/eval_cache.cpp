@@ -0,0 +1 @@
+#include <maestro/evaluator/eval_cache.h>
\ No newline at end of file
@@ -1 +1,180 @@
-#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_gomoku_nn.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/c_runtime_api.h>
+#include <dlpack/dlpack.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace Maestro;
+
+struct Maestro::NNGomokuEvaluator::Runtime {
+    int batch = 0;
+    tvm::runtime::Module lib, graph;
+    tvm::runtime::PackedFunc set_input, run, get_output;
+    DLTensor* input = nullptr;
+    DLTensor* policy = nullptr;
+    DLTensor* value = nullptr;
+
+    ~Runtime() {
+        if (input) TVMArrayFree(input);
+        if (policy) TVMArrayFree(policy);
+        if (value) TVMArrayFree(value);
+    }
+};
+
+namespace {
+    bool read_file(const string& path, string& out) {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        stringstream ss;
+        ss << in.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    DLTensor* alloc_tensor(vector<int64_t> shape) {
+        DLTensor* t = nullptr;
+        if (TVMArrayAlloc(shape.data(), int(shape.size()), kDLFloat, 32, 1, kDLCPU, 0, &t) != 0) {
+            throw runtime_error(string("TVMArrayAlloc failed: ") + TVMGetLastError());
+        }
+        return t;
+    }
+
+    void encode_plane(const Bits256& stones, float* plane) {
+        stones.for_each([plane](int i) { plane[(i >> 4) * BOARD_SIZE + (i & 15)] = 1; });
+    }
+}
+
+Maestro::NNGomokuEvaluator::NNGomokuEvaluator(const string& model_prefix, vector<int> batch_sizes) {
+    const tvm::runtime::PackedFunc* create = tvm::runtime::Registry::Get("tvm.graph_runtime.create");
+    if (!create) throw runtime_error("TVM graph runtime is not registered");
+
+    sort(batch_sizes.begin(), batch_sizes.end());
+    for (int n : batch_sizes) {
+        string prefix = model_prefix + "_b" + std::to_string(n);
+        string graph_json, params;
+        if (!read_file(prefix + ".json", graph_json) || !read_file(prefix + ".params", params)) continue;
+
+        auto rt = make_unique<Runtime>();
+        rt->batch = n;
+        rt->lib = tvm::runtime::Module::LoadFromFile(prefix + ".so");
+        rt->graph = (*create)(graph_json, rt->lib, int(kDLCPU), 0);
+        TVMByteArray params_arr;
+        params_arr.data = params.data();
+        params_arr.size = params.size();
+        rt->graph.GetFunction("load_params")(params_arr);
+        rt->set_input = rt->graph.GetFunction("set_input");
+        rt->run = rt->graph.GetFunction("run");
+        rt->get_output = rt->graph.GetFunction("get_output");
+        rt->input = alloc_tensor({ n, PLANES, BOARD_SIZE, BOARD_SIZE });
+        rt->policy = alloc_tensor({ n, PLANE_SIZE });
+        rt->value = alloc_tensor({ n, 1 });
+        _runtimes.push_back(std::move(rt));
+    }
+    if (_runtimes.empty()) throw runtime_error("no compiled model found at " + model_prefix);
+}
+
+Maestro::NNGomokuEvaluator::~NNGomokuEvaluator() = default;
+
+vector<int> Maestro::NNGomokuEvaluator::batch_sizes() const {
+    vector<int> sizes;
+    for (auto& rt : _runtimes) {
+        sizes.push_back(rt->batch);
+    }
+    return sizes;
+}
+
+void Maestro::NNGomokuEvaluator::encode(const Gomoku& game, float* out) {
+    memset(out, 0, sizeof(float) * PLANES * PLANE_SIZE);
+    bool black_to_move = game.get_color() == Color::A;
+    const Gomoku::HalfBoard& own = black_to_move ? game.black : game.white;
+    const Gomoku::HalfBoard& opp = black_to_move ? game.white : game.black;
+    encode_plane(own.bits(), out);
+    encode_plane(opp.bits(), out + PLANE_SIZE);
+    Move<Gomoku> last = game.get_last_move();
+    if (last.row >= 0) {
+        out[2 * PLANE_SIZE + last.row * BOARD_SIZE + last.col] = 1;
+    }
+    if (black_to_move) {
+        fill(out + 3 * PLANE_SIZE, out + 4 * PLANE_SIZE, 1.0f);
+    }
+}
+
+Evaluation<Gomoku> Maestro::NNGomokuEvaluator::evaluate(const Gomoku& game) {
+    Gomoku* g = const_cast<Gomoku*>(&game);
+    return evaluate(vector<Gomoku*>{ g })[0];
+}
+
+vector<Evaluation<Gomoku>> Maestro::NNGomokuEvaluator::evaluate(const vector<Gomoku*>& games) {
+    vector<Evaluation<Gomoku>> evals(games.size());
+    lock_guard<mutex> guard(_mutex);
+    auto start = chrono::steady_clock::now();
+    int done = 0, total = int(games.size());
+    while (done < total) {
+        int n = total - done;
+        Runtime* rt = _runtimes.back().get();
+        for (auto& r : _runtimes) {
+            if (r->batch >= n) {
+                rt = r.get();
+                break;
+            }
+        }
+        n = min(n, rt->batch);
+        run(*rt, games.data() + done, n, evals.data() + done);
+        done += n;
+    }
+    _busy_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return evals;
+}
+
+void Maestro::NNGomokuEvaluator::run(Runtime& rt, Gomoku* const* games, int n, Evaluation<Gomoku>* out) {
+    // padding samples keep whatever an earlier batch left; their outputs are ignored
+    float* input = static_cast<float*>(rt.input->data);
+    for (int i = 0; i < n; i++) {
+        encode(*games[i], input + i * PLANES * PLANE_SIZE);
+    }
+
+    rt.set_input("data", rt.input);
+    rt.run();
+    rt.get_output(0, rt.policy);
+    rt.get_output(1, rt.value);
+
+    const float* logits = static_cast<const float*>(rt.policy->data);
+    const float* values = static_cast<const float*>(rt.value->data);
+    for (int i = 0; i < n; i++) {
+        const Gomoku& game = *games[i];
+        const float* l = logits + i * PLANE_SIZE;
+        Evaluation<Gomoku>& eval = out[i];
+        eval.v = values[i];
+
+        // softmax over the empty cells
+        Bits256 occupied = game.black.bits() | game.white.bits();
+        float max_logit = -INFINITY;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                if (!occupied.test((r << 4) | c)) max_logit = max(max_logit, l[r * BOARD_SIZE + c]);
+            }
+        }
+        float sum = 0;
+        eval.p.clear();
+        eval.p.reserve(PLANE_SIZE);
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                if (occupied.test((r << 4) | c)) continue;
+                float e = expf(l[r * BOARD_SIZE + c] - max_logit);
+                eval.p.push_back(MovePrior<Gomoku>{ Move<Gomoku>{ r, c }, e });
+                sum += e;
+            }
+        }
+        for (auto& mp : eval.p) {
+            mp.p /= sum;
+        }
+    }
+}
@@ -0,0 +1,229 @@
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <cmath>
+
+using namespace Maestro;
+
+namespace {
+    using Threat = PatternGomokuEvaluator::Threat;
+
+    const int WINDOW = 9, CENTRE = 4;
+    enum Cell : int8_t { EMPTY, OWN, BLOCKED };
+
+    bool is_five(const int8_t* line) {
+        int lo = CENTRE, hi = CENTRE;
+        while (lo > 0 && line[lo - 1] == OWN) lo--;
+        while (hi < WINDOW - 1 && line[hi + 1] == OWN) hi++;
+        int n = hi - lo + 1;
+        return SIX_WIN ? n >= 5 : n == 5;
+    }
+
+    // number of empty cells completing a five through the centre
+    int count_fives(int8_t* line) {
+        int n = 0;
+        for (int i = 0; i < WINDOW; i++) {
+            if (line[i] != EMPTY) continue;
+            line[i] = OWN;
+            n += is_five(line);
+            line[i] = EMPTY;
+        }
+        return n;
+    }
+
+    // the threat through the centre, looking depth stones ahead for the
+    // ones weaker than a four
+    Threat grade(int8_t* line, int depth) {
+        if (is_five(line)) return Threat::FIVE;
+        int n = count_fives(line);
+        if (n > 0) return n > 1 ? Threat::OPEN_FOUR : Threat::FOUR;
+
+        // one stone short of each threat
+        static const Threat SHORT[] = {
+            Threat::NONE, Threat::NONE, Threat::NONE, Threat::TWO,
+            Threat::OPEN_TWO, Threat::THREE, Threat::OPEN_THREE, Threat::NONE
+        };
+        Threat best = Threat::NONE;
+        for (int i = 0; depth > 0 && i < WINDOW; i++) {
+            if (line[i] != EMPTY) continue;
+            line[i] = OWN;
+            best = max(best, SHORT[grade(line, depth - 1)]);
+            line[i] = EMPTY;
+        }
+        return best;
+    }
+
+    // the eight cells around the centre of a window as eight bits
+    inline int squeeze(uint32_t w) {
+        return (w & 0xF) | (w >> 5 & 0xF) << 4;
+    }
+
+    // threats indexed by squeeze(own) | squeeze(blocked) << 8
+    struct ThreatTable {
+        uint8_t threat[1 << 16];
+
+        ThreatTable() {
+            for (int own = 0; own < 256; own++) {
+                for (int blocked = 0; blocked < 256; blocked++) {
+                    int8_t line[WINDOW];
+                    for (int i = 0; i < WINDOW; i++) {
+                        int bit = i < CENTRE ? i : i - 1;
+                        line[i] = i == CENTRE ? OWN : blocked >> bit & 1 ? BLOCKED : own >> bit & 1 ? OWN : EMPTY;
+                    }
+                    threat[own | blocked << 8] = (own & blocked) ? Threat::NONE : grade(line, 2);
+                }
+            }
+        }
+    };
+
+    const ThreatTable& threat_table() {
+        static const ThreatTable table;
+        return table;
+    }
+
+    // Lines through each cell in the four directions. Position p of a line
+    // is kept in bit p + 4 of its masks, so that shifting a mask right by p
+    // leaves the window centred on p in the low nine bits.
+    struct LineGeometry {
+        uint8_t line[4][256], pos[4][256];
+        uint32_t on_board[4][32] = {};
+
+        LineGeometry() {
+            for (int r = 0; r < BOARD_SIZE; r++) {
+                for (int c = 0; c < BOARD_SIZE; c++) {
+                    int cell = Gomoku::cell_index(Move<Gomoku>{ r, c });
+                    const int lines[4] = { r, c, r - c + BOARD_SIZE - 1, r + c };
+                    const int positions[4] = { c, r, r, r };
+                    for (int d = 0; d < 4; d++) {
+                        line[d][cell] = uint8_t(lines[d]);
+                        pos[d][cell] = uint8_t(positions[d]);
+                        on_board[d][lines[d]] |= 1u << (positions[d] + CENTRE);
+                    }
+                }
+            }
+        }
+    };
+
+    const LineGeometry& line_geometry() {
+        static const LineGeometry geometry;
+        return geometry;
+    }
+
+    // a cell's worth to the side making its threats and to the side it
+    // stops, the order of Threat
+    const float ATTACK[] = { 0, 2, 8, 6, 40, 50, 1000, 100000 };
+    const float DEFENCE[] = { 0, 1, 6, 4, 30, 40, 500, 10000 };
+    // the same for the value, where each side counts its own threats
+    const float POTENTIAL[] = { 0, 1, 4, 3, 12, 12, 30, 30 };
+
+    // at least two lines of an open three or better
+    bool is_fork(const Threat* t) {
+        int n = 0;
+        for (int d = 0; d < 4; d++) {
+            n += t[d] >= Threat::OPEN_THREE;
+        }
+        return n >= 2;
+    }
+
+    float score(const Threat* t, const float* weight) {
+        float s = 0;
+        for (int d = 0; d < 4; d++) {
+            s += weight[t[d]];
+        }
+        return is_fork(t) ? s + weight[Threat::OPEN_FOUR] : s;
+    }
+}
+
+PatternGomokuEvaluator::Threat Maestro::PatternGomokuEvaluator::threat(uint32_t own, uint32_t blocked) {
+    return Threat(threat_table().threat[squeeze(own) | squeeze(blocked) << 8]);
+}
+
+Evaluation<Gomoku> Maestro::PatternGomokuEvaluator::evaluate(const Gomoku& game) {
+    Bits256 cells = game.neighbourhood(2);
+    if (cells.none()) {
+        return Evaluation<Gomoku>{ { MovePrior<Gomoku>{ Move<Gomoku>{ 7, 7 }, 1 } }, 0 };
+    }
+
+    const ThreatTable& table = threat_table();
+    const LineGeometry& geo = line_geometry();
+    bool black_to_move = game.get_color() == Color::A;
+    const Bits256& own = black_to_move ? game.black.bits() : game.white.bits();
+    const Bits256& other = black_to_move ? game.white.bits() : game.black.bits();
+
+    // stones along every line, of the side to move and of the other side
+    uint32_t lines[2][4][32] = {};
+    auto add_lines = [&geo](const Bits256& stones, uint32_t(*l)[32]) {
+        stones.for_each([&geo, l](int i) {
+            for (int d = 0; d < 4; d++) {
+                l[d][geo.line[d][i]] |= 1u << (geo.pos[d][i] + CENTRE);
+            }
+        });
+    };
+    add_lines(own, lines[0]);
+    add_lines(other, lines[1]);
+    // cells blocked for either side: the stones of the other one and the
+    // cells off the board
+    uint32_t blocked[2][4][32];
+    for (int d = 0; d < 4; d++) {
+        for (int l = 0; l < 32; l++) {
+            blocked[0][d][l] = lines[1][d][l] | ~geo.on_board[d][l];
+            blocked[1][d][l] = lines[0][d][l] | ~geo.on_board[d][l];
+        }
+    }
+
+    Evaluation<Gomoku> eval;
+    Bits256 near = game.neighbourhood(1);
+    eval.p.reserve(cells.count());
+    // the cells making a five for either side
+    Bits256 wins, blocks;
+    bool strong = false;
+    float potential = 0;
+    for (int i : cells) {
+        Threat attack[4], defence[4];
+        for (int d = 0; d < 4; d++) {
+            int l = geo.line[d][i], p = geo.pos[d][i];
+            attack[d] = Threat(table.threat[squeeze(lines[0][d][l] >> p) | squeeze(blocked[0][d][l] >> p) << 8]);
+            defence[d] = Threat(table.threat[squeeze(lines[1][d][l] >> p) | squeeze(blocked[1][d][l] >> p) << 8]);
+            potential += POTENTIAL[attack[d]] - POTENTIAL[defence[d]];
+        }
+
+        Threat best_attack = max(max(attack[0], attack[1]), max(attack[2], attack[3]));
+        Threat best_defence = max(max(defence[0], defence[1]), max(defence[2], defence[3]));
+        if (best_attack == Threat::FIVE) wins.set(i);
+        if (best_defence == Threat::FIVE) blocks.set(i);
+        strong = strong || best_attack == Threat::OPEN_FOUR || is_fork(attack);
+
+        float s = score(attack, ATTACK) + score(defence, DEFENCE);
+        if (s > 0 || near.test(i)) {
+            eval.p.push_back(MovePrior<Gomoku>{ Gomoku::cell_move(i), 1 + s });
+        }
+    }
+
+    // a five ends the game, and a five of the other side must be blocked
+    const Bits256& forced = wins.any() ? wins : blocks;
+    if (forced.any()) {
+        eval.p.clear();
+        forced.for_each([&eval](int i) {
+            eval.p.push_back(MovePrior<Gomoku>{ Gomoku::cell_move(i), 1 });
+        });
+    }
+    float sum = 0;
+    for (auto& mp : eval.p) {
+        sum += mp.p;
+    }
+    for (auto& mp : eval.p) {
+        mp.p /= sum;
+    }
+
+    if (wins.any()) {
+        eval.v = 1;
+    }
+    else if (blocks.count() > 1) {
+        eval.v = -1;
+    }
+    else if (blocks.none() && strong) {
+        eval.v = 0.9f;
+    }
+    else {
+        eval.v = 0.8f * tanh(potential / 40);
+    }
+    return eval;
+}
@@ -1,90 +1,101 @@
 #include <maestro/evaluator/eval_gomoku_simplistic.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 using namespace Maestro;
 
-Evaluation<Gomoku> Maestro::SimplisticGomokuEvaluator::evaluate(const Gomoku& game) {
-    minstd_rand rnd_eng;
-    rnd_eng.seed(game.get_hash());
-    uniform_real_distribution<float> dist(0, 1E-3);
+namespace {
+    // cells rounded up to whole AVX registers
+    const int MAX_CELLS = (BOARD_SIZE * BOARD_SIZE + 7) & ~7;
 
-    std::vector<MovePrior<Gomoku>> p;
-    p.reserve(10);
+    // tie-breaking jitter in [0, 1e-3), hashed from the position and the cell
+    inline float jitter(uint32_t key, int cell) {
+        uint32_t x = key ^ uint32_t(cell + 1) * 0x9E3779B9u;
+        x = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+        x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+        x ^= x >> 16;
+        return float(int32_t(x >> 8)) * (1E-3f / (1 << 24));
+    }
 
-    float sum = 0;
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            Move<Gomoku> m{ r, c };
-            if (game.is_legal_move_unchecked(m)) {
-                bool found = false;
-                for (int dr = -1; dr <= 1; dr++) {
-                    for (int dc = -1; dc <= 1; dc++) {
-                        if (game.black.safe_get(r + dr, c + dc) || game.white.safe_get(r + dr, c + dc)) {
-                            found = true;
-                            goto break_inner;
-                        }
-                    }
-                }
-            break_inner:
-                if (found) {
-                    float prior = found ? 1 : 0.1;
-                    prior = 1;
-                    prior += dist(rnd_eng);
-                    sum += prior;
-                    p.push_back(MovePrior<Gomoku>{m, prior});
-                }
-            }
+    // Writes 1 + jitter for n cells to prior and returns their sum, taken
+    // as eight interleaved partial sums so both versions agree.
+#ifdef __AVX2__
+    // cell and prior must hold n rounded up to a multiple of 8
+    float jitter_priors(uint32_t key, const int* cell, int n, float* prior) {
+        const __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 scale = _mm256_set1_ps(1E-3f / (1 << 24));
+        const __m256 one = _mm256_set1_ps(1);
+        __m256i k = _mm256_set1_epi32(int(key));
+        __m256 acc = _mm256_setzero_ps();
+        for (int i = 0; i < n; i += 8) {
+            __m256i c = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(cell + i)), _mm256_set1_epi32(1));
+            __m256i x = _mm256_xor_si256(k, _mm256_mullo_epi32(c, _mm256_set1_epi32(int(0x9E3779B9u))));
+            x = _mm256_mullo_epi32(_mm256_xor_si256(x, _mm256_srli_epi32(x, 16)), _mm256_set1_epi32(int(0x85EBCA6Bu)));
+            x = _mm256_mullo_epi32(_mm256_xor_si256(x, _mm256_srli_epi32(x, 13)), _mm256_set1_epi32(int(0xC2B2AE35u)));
+            x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+            __m256 p = _mm256_add_ps(one, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)), scale));
+            // lanes past n are left out of the sum
+            __m256 valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), index));
+            p = _mm256_and_ps(p, valid);
+            _mm256_storeu_ps(prior + i, p);
+            acc = _mm256_add_ps(acc, p);
+        }
+        float partial[8];
+        _mm256_storeu_ps(partial, acc);
+        float sum = 0;
+        for (float s : partial) {
+            sum += s;
+        }
+        return sum;
+    }
+#else
+    float jitter_priors(uint32_t key, const int* cell, int n, float* prior) {
+        float partial[8] = {};
+        for (int i = 0; i < n; i++) {
+            prior[i] = 1 + jitter(key, cell[i]);
+            partial[i & 7] += prior[i];
+        }
+        float sum = 0;
+        for (float s : partial) {
+            sum += s;
         }
+        return sum;
     }
+#endif
+}
 
-    if (p.size() == 0) {
-        sum += 1;
-        p.push_back(MovePrior<Gomoku>{Move<Gomoku>{7, 7}, 1});
+Evaluation<Gomoku> Maestro::SimplisticGomokuEvaluator::evaluate(const Gomoku& game) {
+    // the empty cells next to a stone, in row-major order
+    Bits256 cells = game.neighbourhood(1);
+    int n = cells.count();
+    if (n == 0) {
+        return Evaluation<Gomoku>{ { MovePrior<Gomoku>{ Move<Gomoku>{ 7, 7 }, 1 } }, 0 };
     }
 
-    for (MovePrior<Gomoku>& mp : p) {
-        mp.p = mp.p / sum;
+    alignas(32) int cell[MAX_CELLS];
+    alignas(32) float prior[MAX_CELLS];
+    int n_cells = 0;
+    cells.for_each([&cell, &n_cells](int i) { cell[n_cells++] = i; });
+    while (n_cells & 7) {
+        cell[n_cells++] = 0;
     }
 
-    return Evaluation<Gomoku>{move(p), 0};
-}
+    // equal priors but for the jitter, which is hashed rather than drawn in
+    // sequence so that cells do not wait on each other
+    uint32_t key = uint32_t(game.get_zobrist() ^ game.get_zobrist() >> 32);
+    float scale = 1 / jitter_priors(key, cell, n, prior);
 
-void Maestro::SimplisticGomokuEvaluator::set_check_interval(int d, int& start, int& end) {
-    if (d == 0) {
-        start = 0;
-        end = BOARD_SIZE - 1;
-    }
-    else if (d == -1) {
-        start = 4;
-        end = BOARD_SIZE - 1;
-    }
-    else if (d == 1) {
-        start = 0;
-        end = BOARD_SIZE - 5;
-    }
-    else {
-        assert(0);
+    Evaluation<Gomoku> eval;
+    eval.p.resize(n);
+    for (int i = 0; i < n; i++) {
+        eval.p[i] = MovePrior<Gomoku>{ Gomoku::cell_move(cell[i]), prior[i] * scale };
     }
+    return eval;
 }
 
 int Maestro::SimplisticGomokuEvaluator::check_dir(const Gomoku::HalfBoard& hb, int dr, int dc) {
-    int r_start, r_end, c_start, c_end;
-    set_check_interval(dr, r_start, r_end);
-    set_check_interval(dc, c_start, c_end);
-    int max = 0;
-
-    for (int r = r_start; r <= r_end; r++) {
-        for (int c = c_start; c <= c_end; c++) {
-            bool connect = true;
-            for (int k = 0; k < 5; k++) {
-                connect &= hb.get(r + k * dr, c + k * dc);
-                if (!connect) {
-                    max = k > max ? k : max;
-                    break;
-                }
-            }
-        }
-    }
-    return max;
+    return hb.longest_run(dr, dc);
 }
 
 void Maestro::SimplisticGomokuEvaluator::judge(const Gomoku::HalfBoard& b, const Gomoku::HalfBoard& w, int& max_b, int& max_w) {
@@ -0,0 +1,84 @@
+#include <maestro/evaluator/eval_gomoku_symmetric.h>
+#include <algorithm>
+#include <random>
+
+using namespace Maestro;
+
+Maestro::SymmetricGomokuEvaluator::SymmetricGomokuEvaluator(shared_ptr<IEvaluator<Gomoku>> evaluator, int n_symmetries, uint64_t seed) :
+    _evaluator(std::move(evaluator)),
+    _n_symmetries(clamp(n_symmetries, 1, Symmetry<Gomoku>::COUNT)),
+    _seed(seed) {}
+
+void Maestro::SymmetricGomokuEvaluator::pick_symmetries(const Gomoku& game, int* syms) const {
+    const int n = Symmetry<Gomoku>::COUNT;
+    int all[n];
+    for (int i = 0; i < n; i++) {
+        all[i] = i;
+    }
+    if (_n_symmetries < n) {
+        // partial Fisher-Yates, keyed by the position
+        minstd_rand rnd_eng(uint32_t((game.get_zobrist() ^ _seed) * 0x9E3779B97F4A7C15 >> 33));
+        for (int i = 0; i < _n_symmetries; i++) {
+            swap(all[i], all[i + rnd_eng() % (n - i)]);
+        }
+    }
+    copy(all, all + _n_symmetries, syms);
+}
+
+Evaluation<Gomoku> Maestro::SymmetricGomokuEvaluator::evaluate(const Gomoku& game) {
+    Gomoku* g = const_cast<Gomoku*>(&game);
+    return evaluate(vector<Gomoku*>{ g })[0];
+}
+
+vector<Evaluation<Gomoku>> Maestro::SymmetricGomokuEvaluator::evaluate(const vector<Gomoku*>& games) {
+    const int k = _n_symmetries;
+    vector<int> syms(games.size() * k);
+    vector<Gomoku> transformed;
+    transformed.reserve(games.size() * k);
+    for (int i = 0; i < int(games.size()); i++) {
+        pick_symmetries(*games[i], &syms[i * k]);
+        for (int j = 0; j < k; j++) {
+            transformed.push_back(games[i]->transformed(syms[i * k + j]));
+        }
+    }
+
+    vector<Gomoku*> ptrs;
+    for (auto& g : transformed) {
+        ptrs.push_back(&g);
+    }
+    vector<Evaluation<Gomoku>> results = _evaluator->evaluate(ptrs);
+
+    vector<Evaluation<Gomoku>> evals(games.size());
+    for (int i = 0; i < int(games.size()); i++) {
+        Evaluation<Gomoku>& eval = evals[i];
+        if (k == 1) {
+            eval = std::move(results[i]);
+            int inv = Symmetry<Gomoku>::inverse(syms[i]);
+            for (auto& mp : eval.p) {
+                mp.move = Symmetry<Gomoku>::apply(mp.move, inv);
+            }
+            continue;
+        }
+
+        // priors summed per cell, in the layout of HalfBoard
+        float p[256] = {};
+        Bits256 present;
+        float v = 0;
+        for (int j = 0; j < k; j++) {
+            Evaluation<Gomoku>& r = results[i * k + j];
+            int inv = Symmetry<Gomoku>::inverse(syms[i * k + j]);
+            for (auto& mp : r.p) {
+                Move<Gomoku> m = Symmetry<Gomoku>::apply(mp.move, inv);
+                int idx = (m.row << 4) | m.col;
+                p[idx] += mp.p;
+                present.set(idx);
+            }
+            v += r.v;
+        }
+        eval.v = v / k;
+        present.for_each([&eval, &p, k](int idx) {
+            eval.p.push_back(MovePrior<Gomoku>{ Move<Gomoku>{ idx >> 4, idx & 15 }, p[idx] / k });
+        });
+    }
+    return evals;
+}
@@ -0,0 +1 @@
+#include <maestro/evaluator/inference_server.h>
\ No newline at end of file
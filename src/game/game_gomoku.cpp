@@ -2,72 +2,139 @@
 
 using namespace Maestro;
 
-void Maestro::Gomoku::set_check_interval(int d, int& start, int& end) {
-    if (d == 0) {
-        start = 0;
-        end = BOARD_SIZE - 1;
+namespace {
+    struct ZobristTable {
+        uint64_t keys[2][256] = {};
+        constexpr ZobristTable() {
+            // splitmix64 with a fixed seed, so hashes are stable across runs
+            uint64_t x = 0x4D61657374726F21;
+            for (auto& color_keys : keys) {
+                for (auto& key : color_keys) {
+                    uint64_t z = (x += 0x9E3779B97F4A7C15);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+                    key = z ^ (z >> 31);
+                }
+            }
+        }
+    };
+
+    constexpr ZobristTable zobrist_table;
+}
+
+uint64_t Maestro::Gomoku::zobrist_key(Color color, Move<Gomoku> mov) {
+    assert(color != Color::None);
+    return zobrist_table.keys[int(color) - 1][(mov.row << 4) | mov.col];
+}
+
+int Maestro::Gomoku::HalfBoard::longest_run(int dr, int dc, int cap) const {
+    Bits256 r = _stones;
+    if (r.none()) return 0;
+    int n = 1;
+    for (; n < cap; n++) {
+        switch (stride(dr, dc)) {
+        case STRIDE_ROW: r &= r.shr<STRIDE_ROW>(); break;
+        case STRIDE_COL: r &= r.shr<STRIDE_COL>(); break;
+        case STRIDE_DIAG: r &= r.shr<STRIDE_DIAG>(); break;
+        case STRIDE_ANTI_DIAG: r &= r.shr<STRIDE_ANTI_DIAG>(); break;
+        default: assert(0);
+        }
+        if (r.none()) break;
     }
-    else if (d == -1) {
-        start = 4;
-        end = BOARD_SIZE - 1;
+    return n;
+}
+
+Maestro::Gomoku::HalfBoard Maestro::Gomoku::HalfBoard::transformed(int sym) const {
+    Bits256 r = _stones;
+    if (sym & 4) r = r.transpose16();
+    // mirroring the 16 wide matrix moves the empty padding line to the
+    // front; shift it back out
+    if (sym & 1) r = r.flip_cols16().shr<1>();
+    if (sym & 2) r = r.flip_rows16().shr<16>();
+    return HalfBoard(r);
+}
+
+Maestro::Gomoku Maestro::Gomoku::transformed(int sym) const {
+    Gomoku g = *this;
+    g.black = black.transformed(sym);
+    g.white = white.transformed(sym);
+    if (_last_move.row >= 0) {
+        g._last_move = Symmetry<Gomoku>::apply(_last_move, sym);
     }
-    else if (d == 1) {
-        start = 0;
-        end = BOARD_SIZE - 5;
+    g._zobrist = 0;
+    g.black.bits().for_each([&g](int i) { g._zobrist ^= zobrist_table.keys[0][i]; });
+    g.white.bits().for_each([&g](int i) { g._zobrist ^= zobrist_table.keys[1][i]; });
+    return g;
+}
+
+int Maestro::Symmetry<Gomoku>::canonical(const Gomoku& game) {
+    int best = 0;
+    Bits256 best_black = game.black.bits(), best_white = game.white.bits();
+    for (int sym = 1; sym < COUNT; sym++) {
+        Bits256 b = game.black.transformed(sym).bits();
+        if (best_black < b) continue;
+        Bits256 w = game.white.transformed(sym).bits();
+        if (b < best_black || w < best_white) {
+            best = sym;
+            best_black = b;
+            best_white = w;
+        }
+    }
+    return best;
+}
+
+Status Maestro::Gomoku::check_status() const {
+    Status status;
+    if (black.has_five()) {
+        status.end = true;
+        status.winner = Color::A;
+    }
+    else if (white.has_five()) {
+        status.end = true;
+        status.winner = Color::B;
     }
     else {
-        assert(0);
+        // filled iff every on-board cell is taken by either side
+        status.end = empty_cells().none();
+        status.winner = Color::None;
     }
+    return status;
 }
 
-bool Maestro::Gomoku::check_dir(const HalfBoard& hb, int dr, int dc) {
-    int r_start, r_end, c_start, c_end;
-    set_check_interval(dr, r_start, r_end);
-    set_check_interval(dc, c_start, c_end);
-
-    for (int r = r_start; r <= r_end; r++) {
-        for (int c = c_start; c <= c_end; c++) {
-            bool connect = true;
-            for (int k = 0; k < 5; k++) {
-                connect &= hb.get(r + k * dr, c + k * dc);
-                if (!connect) break;
-            }
-            if (connect) connect = SIX_WIN || (!hb.safe_get(r - dr, c - dc) && !hb.safe_get(r + 5 * dr, c + 5 * dc));
-            if (connect) return true;
-        }
+int Maestro::Gomoku::count_dir(const HalfBoard& hb, Move<Gomoku> from, int dr, int dc) const {
+    int n = 0;
+    int r = from.row + dr, c = from.col + dc;
+    while (hb.safe_get(r, c)) {
+        n++;
+        r += dr;
+        c += dc;
     }
-    return false;
+    return n;
 }
 
-void Maestro::Gomoku::check_status() {
-    for (int cc = 0; cc <= 1; cc++) {
-        const HalfBoard& hb = cc == 0 ? black : white;
-        Color cur_color = cc == 0 ? Color::A : Color::B;
-
-        if (check_dir(hb, 1, 1) ||
-            check_dir(hb, 1, -1) ||
-            check_dir(hb, 0, 1) ||
-            check_dir(hb, 1, 0)) {
-            _status.end = true;
-            _status.winner = cur_color;
-            return;
-        }
-    }
+bool Maestro::Gomoku::check_line(const HalfBoard& hb, Move<Gomoku> mov, int dr, int dc) const {
+    int len = 1 + count_dir(hb, mov, dr, dc) + count_dir(hb, mov, -dr, -dc);
+    return SIX_WIN ? len >= 5 : len == 5;
+}
 
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            // if not filled
-            if (!black.get(r, c) && !white.get(r, c)) {
-                _status.end = false;
-                _status.winner = Color::None;
-                return;
-            }
-        }
+void Maestro::Gomoku::update_status(Color mover, Move<Gomoku> mov) {
+    // the game was not over before this move, so a new five can only be
+    // made by the mover and must pass through the stone just placed
+    const HalfBoard& hb = mover == Color::A ? black : white;
+    if (check_line(hb, mov, 1, 1) ||
+        check_line(hb, mov, 1, -1) ||
+        check_line(hb, mov, 0, 1) ||
+        check_line(hb, mov, 1, 0)) {
+        _status.end = true;
+        _status.winner = mover;
+        return;
     }
 
-    // filled
-    _status.end = true;
-    _status.winner = Color::None;
+    // every move places exactly one stone, so _steps is the stone count
+    if (_steps >= BOARD_SIZE * BOARD_SIZE) {
+        _status.end = true;
+        _status.winner = Color::None;
+    }
 }
 
 void Maestro::Gomoku::move(Move<Gomoku> mov) {
@@ -83,22 +150,38 @@ void Maestro::Gomoku::move(Move<Gomoku> mov) {
     else if (_color == Color::B) {
         white.set(mov, true);
     }
+    Color mover = _color;
+    _zobrist ^= zobrist_key(mover, mov);
     _color = another_color(_color);
 
-    check_status();
+    update_status(mover, mov);
 }
 
 vector<Move<Gomoku>> Maestro::Gomoku::get_all_legal_moves() const {
-    vector<Move<Gomoku>> ms;
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            Move<Gomoku> m{ r,c };
-            if (is_legal_move(m)) ms.push_back(m);
-        }
-    }
+    Bits256 cells = legal_moves().cells();
+    vector<Move<Gomoku>> ms(cells.count());
+    int j = 0;
+    cells.for_each([&ms, &j](int i) { ms[j++] = cell_move(i); });
     return ms;
 }
 
+Bits256 Maestro::Gomoku::dilate(const Bits256& cells) {
+    // masking after each step keeps bits from wrapping through the
+    // padding column into the next row
+    const Bits256 board = board_cells();
+    Bits256 h = (cells | cells.shl<1>() | cells.shr<1>()) & board;
+    return (h | h.shl<16>() | h.shr<16>()) & board;
+}
+
+Bits256 Maestro::Gomoku::neighbourhood(int d) const {
+    Bits256 stones = black.bits() | white.bits();
+    Bits256 r = stones;
+    for (int i = 0; i < d; i++) {
+        r = dilate(r);
+    }
+    return r.and_not(stones);
+}
+
 string Maestro::Gomoku::to_string() const {
     ostringstream out;
     out << "step " << _steps << endl;
@@ -0,0 +1,58 @@
+#include <maestro/play/elo.h>
+#include <cmath>
+#include <algorithm>
+
+using namespace Maestro;
+
+double Maestro::elo_to_score(double elo) {
+    return 1 / (1 + pow(10, -elo / 400));
+}
+
+double Maestro::score_to_elo(double score) {
+    return -400 * log10(1 / score - 1);
+}
+
+EloEstimate Maestro::EloEstimate::from(int wins, int losses, int draws, double z) {
+    double w = wins + 0.5, l = losses + 0.5, d = draws;
+    double n = w + l + d;
+    EloEstimate e;
+    e.score = (w + d / 2) / n;
+    e.variance = (w * pow(1 - e.score, 2) + l * pow(e.score, 2) + d * pow(0.5 - e.score, 2)) / n;
+    double margin = z * sqrt(e.variance / n);
+    // keep the bounds finite
+    const double eps = 1e-6;
+    e.elo = score_to_elo(e.score);
+    e.lower = score_to_elo(max(eps, e.score - margin));
+    e.upper = score_to_elo(min(1 - eps, e.score + margin));
+    return e;
+}
+
+double Maestro::Sprt::llr(int wins, int losses, int draws) const {
+    EloEstimate e = EloEstimate::from(wins, losses, draws);
+    double n = wins + losses + draws;
+    double s0 = elo_to_score(_config.elo0), s1 = elo_to_score(_config.elo1);
+    return n * (s1 - s0) * (2 * e.score - s0 - s1) / (2 * e.variance);
+}
+
+double Maestro::Sprt::lower_bound() const {
+    return log(_config.beta / (1 - _config.alpha));
+}
+
+double Maestro::Sprt::upper_bound() const {
+    return log((1 - _config.beta) / _config.alpha);
+}
+
+Sprt::Result Maestro::Sprt::test(int wins, int losses, int draws) const {
+    double r = llr(wins, losses, draws);
+    if (r >= upper_bound()) return Result::H1;
+    if (r <= lower_bound()) return Result::H0;
+    return Result::Continue;
+}
+
+const char* Maestro::Sprt::name(Result result) {
+    switch (result) {
+    case Result::H0: return "H0";
+    case Result::H1: return "H1";
+    default: return "continue";
+    }
+}
@@ -0,0 +1,125 @@
+#include <maestro/play/self_play.h>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+using namespace Maestro;
+
+namespace {
+    // Adds a record of the search of the wrapped player before each of its
+    // moves, and draws the moves up to sample_plies from the visits.
+    class RecordingPlayer final : public IPlayer<Gomoku> {
+        shared_ptr<MonteCarloAIPlayer<Gomoku>> _player;
+        vector<GomokuRecord>& _records;
+        int _sample_plies;
+    public:
+        RecordingPlayer(shared_ptr<MonteCarloAIPlayer<Gomoku>> player, vector<GomokuRecord>& records, int sample_plies) :
+            _player(std::move(player)), _records(records), _sample_plies(sample_plies) {}
+
+        Move<Gomoku> get_move(const Gomoku& game) override {
+            Move<Gomoku> m = _player->get_move(game);
+            auto search = _player->search();
+            _records.push_back(GomokuRecord::from(game, search->get_moves(), search->get_value(game.get_color())));
+            if (int(_records.size()) <= _sample_plies) {
+                m = search->pick_move(1);
+            }
+            return m;
+        }
+
+        void move(Move<Gomoku> m) override {
+            _player->move(m);
+        }
+    };
+
+    uint32_t game_seed(uint32_t seed, int game, int side) {
+        uint64_t x = (uint64_t(seed) << 32 | uint32_t(2 * game + side)) * 0x9E3779B97F4A7C15;
+        return uint32_t(x >> 32);
+    }
+}
+
+Maestro::SelfPlay::SelfPlay(shared_ptr<IEvaluator<Gomoku>> evaluator, string prefix) :
+    SelfPlay(std::move(evaluator), std::move(prefix), Config()) {}
+
+Maestro::SelfPlay::SelfPlay(shared_ptr<IEvaluator<Gomoku>> evaluator, string prefix, Config config) :
+    _evaluator(std::move(evaluator)), _prefix(std::move(prefix)), _config(config) {}
+
+string Maestro::SelfPlay::shard_path(int thread) const {
+    return _prefix + "-" + std::to_string(thread) + ".bin";
+}
+
+SelfPlay::Stat Maestro::SelfPlay::play(int n_games) {
+    int n_threads = max(1, _config.n_threads);
+    // opened up front, so that a bad path throws here rather than in a worker
+    vector<unique_ptr<TrainingDataWriter>> writers;
+    for (int t = 0; t < n_threads; t++) {
+        writers.push_back(make_unique<TrainingDataWriter>(shard_path(t)));
+    }
+
+    atomic<int> next{ 0 };
+    vector<Stat> stats(n_threads);
+    auto worker = [&](int t) {
+        vector<GomokuRecord> records;
+        Stat& stat = stats[t];
+        for (int i = next++; i < n_games; i = next++) {
+            records.clear();
+            auto make_player = [&](int side) {
+                auto search = make_shared<MonteCarloGraphSearch<Gomoku>>(_evaluator, Gomoku(), _config.search);
+                search->seed(game_seed(_config.seed, i, side));
+                auto player = make_shared<MonteCarloAIPlayer<Gomoku>>(search, _config.n_sim);
+                return make_shared<RecordingPlayer>(player, records, _config.sample_plies);
+            };
+            Round<Gomoku> round(Gomoku(), make_player(0), make_player(1));
+            round.step_to_end();
+
+            Color winner = round.game().get_status().winner;
+            for (auto& r : records) {
+                bool black_won = winner == Color::A;
+                r.outcome = winner == Color::None ? 0 : black_won == bool(r.black_to_move) ? 1 : -1;
+            }
+            writers[t]->write(records.data(), records.size());
+            stat.games++;
+            stat.positions += records.size();
+            stat.black_win += winner == Color::A;
+            stat.white_win += winner == Color::B;
+            stat.draw += winner == Color::None;
+        }
+        writers[t]->flush();
+    };
+
+    // a failing worker stops the others from starting games, and its
+    // exception is rethrown once all have been joined
+    vector<exception_ptr> errors(n_threads);
+    auto guarded = [&](int t) {
+        try {
+            worker(t);
+        }
+        catch (...) {
+            errors[t] = current_exception();
+            next = n_games;
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 1; t < n_threads; t++) {
+        threads.emplace_back(guarded, t);
+    }
+    guarded(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& e : errors) {
+        if (e) rethrow_exception(e);
+    }
+
+    Stat total;
+    total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (auto& s : stats) {
+        total.games += s.games;
+        total.black_win += s.black_win;
+        total.white_win += s.white_win;
+        total.draw += s.draw;
+        total.positions += s.positions;
+    }
+    return total;
+}
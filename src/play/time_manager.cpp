@@ -0,0 +1,20 @@
+#include <maestro/play/time_manager.h>
+
+using namespace Maestro;
+
+double Maestro::TimeManager::nominal(double clock_seconds, double increment_seconds) const {
+    double t = clock_seconds / max(1.0, _config.moves_to_go) + increment_seconds * _config.increment_use;
+    t = min(t, clock_seconds * _config.max_clock_share);
+    return max(0.0, min(t, clock_seconds - _config.safety_seconds));
+}
+
+double Maestro::TimeManager::move_time(double nominal, const SearchReport& first) const {
+    if (first.best_share >= _config.forced_share) {
+        return nominal * min(_config.first_part, _config.min_factor);
+    }
+    // 1 for an average position; up to one more for each of an even
+    // spread of visits and a value that keeps moving
+    float unsettled = min(1.0f, first.value_stddev / _config.unsettled_stddev);
+    double factor = 0.5 + first.visit_entropy + unsettled;
+    return nominal * clamp(factor, _config.min_factor, _config.max_factor);
+}
@@ -0,0 +1,142 @@
+#include <maestro/play/training_data.h>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace Maestro;
+
+namespace {
+    void check_header(const TrainingFileHeader& header, const string& path) {
+        TrainingFileHeader expected;
+        if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+            header.version != expected.version || header.record_size != expected.record_size) {
+            throw runtime_error("not a training data file of this version: " + path);
+        }
+    }
+
+    // 64-bit even where long is not, so shards past 2 GiB are measured right
+    uintmax_t file_bytes(FILE* file, const string& path) {
+        error_code ec;
+        uintmax_t bytes = filesystem::file_size(path, ec);
+        if (ec) {
+            fclose(file);
+            throw runtime_error("cannot read the size of " + path + ": " + ec.message());
+        }
+        return bytes;
+    }
+}
+
+GomokuRecord Maestro::GomokuRecord::from(const Gomoku& game, const vector<MoveVisit<Gomoku>>& visits, float search_value) {
+    GomokuRecord r;
+    memset(&r, 0, sizeof(r));
+    for (int k = 0; k < 4; k++) {
+        r.black[k] = game.black.bits().word(k);
+        r.white[k] = game.white.bits().word(k);
+    }
+    int total = 0;
+    for (auto& mv : visits) {
+        total += mv.visit_count;
+    }
+    for (auto& mv : visits) {
+        if (total > 0) {
+            r.policy[mv.move.row * BOARD_SIZE + mv.move.col] = uint16_t(65535.0 * mv.visit_count / total + 0.5);
+        }
+    }
+    r.black_to_move = game.get_color() == Color::A;
+    r.last_row = int8_t(game.get_last_move().row);
+    r.last_col = int8_t(game.get_last_move().col);
+    r.search_value = search_value;
+    return r;
+}
+
+Maestro::TrainingDataWriter::TrainingDataWriter(const string& path) {
+    _file = fopen(path.c_str(), "a+b");
+    if (!_file) throw runtime_error("cannot open " + path);
+    uintmax_t size = file_bytes(_file, path);
+    if (size == 0) {
+        TrainingFileHeader header;
+        fwrite(&header, sizeof(header), 1, _file);
+        return;
+    }
+    TrainingFileHeader header;
+    fseek(_file, 0, SEEK_SET);
+    bool ok = fread(&header, sizeof(header), 1, _file) == 1;
+    fseek(_file, 0, SEEK_END);
+    try {
+        if (!ok) throw runtime_error("truncated header in " + path);
+        check_header(header, path);
+    }
+    catch (...) {
+        fclose(_file);
+        throw;
+    }
+    // a run that died in the middle of a record left a torn tail: cut it
+    // off, or every record appended after it would be misaligned
+    uintmax_t tail = (size - sizeof(header)) % sizeof(GomokuRecord);
+    if (tail != 0) {
+        fclose(_file);
+        error_code ec;
+        filesystem::resize_file(path, size - tail, ec);
+        if (ec) throw runtime_error("cannot cut the torn record off " + path + ": " + ec.message());
+        _file = fopen(path.c_str(), "a+b");
+        if (!_file) throw runtime_error("cannot open " + path);
+    }
+}
+
+Maestro::TrainingDataWriter::~TrainingDataWriter() {
+    fclose(_file);
+}
+
+void Maestro::TrainingDataWriter::write(const GomokuRecord* records, size_t n) {
+    if (fwrite(records, sizeof(GomokuRecord), n, _file) != n) {
+        throw runtime_error("writing training data failed");
+    }
+    _written += n;
+}
+
+void Maestro::TrainingDataWriter::flush() {
+    fflush(_file);
+}
+
+Maestro::TrainingDataReader::TrainingDataReader(const string& path, size_t buffer_records) :
+    _buffer(max<size_t>(1, buffer_records)) {
+    _file = fopen(path.c_str(), "rb");
+    if (!_file) throw runtime_error("cannot open " + path);
+    TrainingFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, _file) == 1;
+    uintmax_t size = file_bytes(_file, path);
+    try {
+        if (!ok) throw runtime_error("truncated header in " + path);
+        check_header(header, path);
+        if ((size - sizeof(header)) % sizeof(GomokuRecord) != 0) throw runtime_error("truncated record in " + path);
+    }
+    catch (...) {
+        fclose(_file);
+        throw;
+    }
+    _size = size_t((size - sizeof(header)) / sizeof(GomokuRecord));
+}
+
+Maestro::TrainingDataReader::~TrainingDataReader() {
+    fclose(_file);
+}
+
+bool Maestro::TrainingDataReader::next(GomokuRecord& record) {
+    return read(&record, 1) == 1;
+}
+
+size_t Maestro::TrainingDataReader::read(GomokuRecord* out, size_t n) {
+    size_t copied = 0;
+    while (copied < n) {
+        if (_pos == _end) {
+            _pos = 0;
+            _end = fread(_buffer.data(), sizeof(GomokuRecord), _buffer.size(), _file);
+            if (_end == 0) break;
+        }
+        size_t k = min(n - copied, _end - _pos);
+        memcpy(out + copied, &_buffer[_pos], k * sizeof(GomokuRecord));
+        _pos += k;
+        copied += k;
+    }
+    return copied;
+}
@@ -0,0 +1,120 @@
+#include <maestro/search/puct.h>
+#include <algorithm>
+#include <cmath>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace Maestro;
+
+namespace {
+    inline float slot_score(const EdgeLane& lane, int k, float c, float virtual_loss) {
+        float visit = float(lane.visit[k]);
+        float u = 1 + lane.q[k];
+        u -= lane.vl[k] * virtual_loss / max(1.0f, visit);
+        u += c * lane.p[k] / (1 + visit);
+        return u;
+    }
+
+#ifdef __AVX2__
+    inline __m256 lane_score(const EdgeLane& lane, __m256 c, __m256 virtual_loss) {
+        const __m256 one = _mm256_set1_ps(1);
+        __m256 visit = _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i*)lane.visit));
+        __m256 vl = _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i*)lane.vl));
+        __m256 u = _mm256_add_ps(one, _mm256_load_ps(lane.q));
+        u = _mm256_sub_ps(u, _mm256_div_ps(_mm256_mul_ps(vl, virtual_loss), _mm256_max_ps(one, visit)));
+        u = _mm256_add_ps(u, _mm256_div_ps(_mm256_mul_ps(c, _mm256_load_ps(lane.p)), _mm256_add_ps(one, visit)));
+        return u;
+    }
+#endif
+}
+
+void Maestro::pad_edge_lanes(EdgeLane* lanes, int n) {
+    if (n <= 0) return;
+    EdgeLane& last = lanes[(n - 1) >> 3];
+    for (int k = ((n - 1) & 7) + 1; k < 8; k++) {
+        last.p[k] = 0;
+        last.q[k] = EDGE_PAD_Q;
+        last.visit[k] = 0;
+        last.vl[k] = 0;
+    }
+}
+
+int Maestro::puct_argmax_scalar(const EdgeLane* lanes, int n, float c, float virtual_loss) {
+    int max_idx = -1;
+    float max_ucb = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        float ucb = slot_score(lanes[i >> 3], i & 7, c, virtual_loss);
+        if (ucb >= max_ucb) {
+            max_ucb = ucb;
+            max_idx = i;
+        }
+    }
+    return max_idx;
+}
+
+void Maestro::puct_scores_scalar(const EdgeLane* lanes, int n, float c, float virtual_loss, float* out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = slot_score(lanes[i >> 3], i & 7, c, virtual_loss);
+    }
+}
+
+#ifdef __AVX2__
+
+int Maestro::puct_argmax(const EdgeLane* lanes, int n, float c, float virtual_loss) {
+    if (n <= 0) return -1;
+    __m256 vc = _mm256_set1_ps(c), vvl = _mm256_set1_ps(virtual_loss);
+
+    // per slot running maximum; padding slots never win
+    __m256 best = _mm256_set1_ps(-INFINITY);
+    __m256i best_idx = _mm256_set1_epi32(-1);
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    int n_lanes = edge_lane_count(n);
+    for (int l = 0; l < n_lanes; l++) {
+        __m256 u = lane_score(lanes[l], vc, vvl);
+        __m256 ge = _mm256_cmp_ps(u, best, _CMP_GE_OQ);
+        best = _mm256_blendv_ps(best, u, ge);
+        best_idx = _mm256_blendv_epi8(best_idx, idx, _mm256_castps_si256(ge));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    alignas(32) float v[8];
+    alignas(32) int32_t k[8];
+    _mm256_store_ps(v, best);
+    _mm256_store_si256((__m256i*)k, best_idx);
+    int max_idx = k[0];
+    float max_ucb = v[0];
+    for (int j = 1; j < 8; j++) {
+        if (v[j] > max_ucb || (v[j] == max_ucb && k[j] > max_idx)) {
+            max_ucb = v[j];
+            max_idx = k[j];
+        }
+    }
+    return max_idx;
+}
+
+void Maestro::puct_scores(const EdgeLane* lanes, int n, float c, float virtual_loss, float* out) {
+    __m256 vc = _mm256_set1_ps(c), vvl = _mm256_set1_ps(virtual_loss);
+    int l = 0;
+    for (; (l + 1) * 8 <= n; l++) {
+        _mm256_storeu_ps(out + l * 8, lane_score(lanes[l], vc, vvl));
+    }
+    if (l * 8 < n) {
+        alignas(32) float tail[8];
+        _mm256_store_ps(tail, lane_score(lanes[l], vc, vvl));
+        copy(tail, tail + n - l * 8, out + l * 8);
+    }
+}
+
+#else
+
+int Maestro::puct_argmax(const EdgeLane* lanes, int n, float c, float virtual_loss) {
+    return puct_argmax_scalar(lanes, n, c, virtual_loss);
+}
+
+void Maestro::puct_scores(const EdgeLane* lanes, int n, float c, float virtual_loss, float* out) {
+    puct_scores_scalar(lanes, n, c, virtual_loss, out);
+}
+
+#endif
@@ -0,0 +1 @@
+#include <maestro/search/search_tree_compact.h>
\ No newline at end of file
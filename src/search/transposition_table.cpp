@@ -0,0 +1 @@
+#include <maestro/search/transposition_table.h>
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "test.h"
 #include <maestro/game/game_gomoku.h>
+#include <random>
 
 using namespace Maestro;
 
@@ -77,4 +78,191 @@ TEST_CASE(gomoku_could_transfer) {
 
     expect(g1.could_transfer_to(g2), "could transfer");
     expect(!g2.could_transfer_to(g1), "could not transfer");
-}
\ No newline at end of file
+}
+
+TEST_CASE(gomoku_incremental_status) {
+    // differential check of the incremental status update against a full
+    // rescan; random games end in a win almost always
+    const int n_games = 2000;
+    minstd_rand rnd_eng(12345);
+
+    for (int i = 0; i < n_games; i++) {
+        Gomoku gomoku;
+        while (!gomoku.get_status().end) {
+            auto moves = gomoku.get_all_legal_moves();
+            uniform_int_distribution<int> dist(0, int(moves.size()) - 1);
+            gomoku.move(moves[dist(rnd_eng)]);
+
+            Status s1 = gomoku.get_status();
+            Status s2 = gomoku.check_status();
+            expect(s1.end == s2.end, "status end mismatch");
+            expect(s1.winner == s2.winner, "status winner mismatch");
+        }
+    }
+
+    // a full board without five: coloured by (c + 2r) / 2 % 2, stones come
+    // in pairs along rows and anti-diagonals, alternate along columns, and
+    // run at most two along diagonals
+    vector<Move<Gomoku>> cells[2];
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            cells[(c + 2 * r) / 2 % 2].push_back(Move<Gomoku>{ r, c });
+        }
+    }
+    expect(cells[0].size() == cells[1].size() + 1, "black has the extra stone");
+    Gomoku gomoku;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        gomoku.move(cells[i % 2][i / 2]);
+        Status s1 = gomoku.get_status();
+        Status s2 = gomoku.check_status();
+        expect(s1.end == s2.end && s1.winner == s2.winner, "status mismatch on the full board");
+        expect(s1.end == (i == BOARD_SIZE * BOARD_SIZE - 1), "ends once the board is full");
+    }
+    expect(gomoku.get_status().winner == Color::None, "full board is a draw");
+}
+
+TEST_CASE(gomoku_bitboard_kernel) {
+    // shift-and-mask line detection against a per-cell scan on random boards
+    minstd_rand rnd_eng(54321);
+    uniform_real_distribution<float> dist;
+    const int dirs[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+
+    for (int i = 0; i < 20000; i++) {
+        Gomoku::HalfBoard hb;
+        float density = dist(rnd_eng);
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                hb.set(r, c, dist(rnd_eng) < density);
+            }
+        }
+
+        bool five = false;
+        for (auto& d : dirs) {
+            int longest = 0;
+            for (int r = 0; r < BOARD_SIZE; r++) {
+                for (int c = 0; c < BOARD_SIZE; c++) {
+                    if (!hb.get(r, c) || hb.safe_get(r - d[0], c - d[1])) continue;
+                    int len = 0;
+                    while (hb.safe_get(r + len * d[0], c + len * d[1])) len++;
+                    longest = max(longest, len);
+                    five |= SIX_WIN ? len >= 5 : len == 5;
+                }
+            }
+            expect(hb.longest_run(d[0], d[1], BOARD_SIZE) == longest, "longest run mismatch");
+        }
+        expect(hb.has_five() == five, "five mismatch");
+    }
+}
+
+TEST_CASE(gomoku_zobrist) {
+    using M = Move<Gomoku>;
+    Gomoku g1, g2;
+    g1.move(M{ 7,7 });
+    g1.move(M{ 3,4 });
+    g1.move(M{ 8,8 });
+    g2.move(M{ 8,8 });
+    g2.move(M{ 3,4 });
+    g2.move(M{ 7,7 });
+    expect(g1 == g2, "transposed games should equal");
+    expect(g1.get_hash() == g2.get_hash(), "transposed games should hash equal");
+
+    Gomoku g3;
+    g3.move(M{ 3,4 });
+    g3.move(M{ 7,7 });
+    g3.move(M{ 8,8 });
+    expect(!(g1 == g3), "colors swapped");
+    expect(g1.get_hash() != g3.get_hash(), "colors swapped should hash differently");
+    expect(Gomoku().get_hash() == 0, "empty board");
+}
+
+TEST_CASE(gomoku_symmetry) {
+    using M = Move<Gomoku>;
+    using S = Symmetry<Gomoku>;
+    minstd_rand rnd_eng(2468);
+    Gomoku g;
+    for (int i = 0; i < 30; i++) {
+        auto moves = g.get_all_legal_moves();
+        g.move(moves[rnd_eng() % moves.size()]);
+        if (g.get_status().end) break;
+    }
+
+    int canonical = S::canonical(g);
+    for (int sym = 0; sym < S::COUNT; sym++) {
+        Gomoku t = S::apply(g, sym);
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                M m = S::apply(M{ r, c }, sym);
+                expect(t.black.get(m) == g.black.get(r, c) && t.white.get(m) == g.white.get(r, c), "stones follow their cells");
+                expect(S::apply(m, S::inverse(sym)) == M{ r, c }, "inverse");
+            }
+        }
+        expect(t.get_last_move() == S::apply(g.get_last_move(), sym), "last move");
+        expect(t.get_color() == g.get_color() && t.get_status().end == g.get_status().end, "same side to move");
+
+        // the hash is the one of the transformed stones
+        uint64_t h = 0;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                if (t.black.get(r, c)) h ^= Gomoku::zobrist_key(Color::A, M{ r, c });
+                if (t.white.get(r, c)) h ^= Gomoku::zobrist_key(Color::B, M{ r, c });
+            }
+        }
+        expect(t.get_hash() == h, "hash of the transformed stones");
+
+        // every orientation leads to the same representative
+        Gomoku rep = S::apply(t, S::canonical(t));
+        expect(rep == S::apply(g, canonical) && rep.get_hash() == S::apply(g, canonical).get_hash(), "canonical");
+    }
+}
+
+TEST_CASE(gomoku_legal_moves) {
+    using M = Move<Gomoku>;
+    minstd_rand rnd_eng(1357);
+    for (int i = 0; i < 200; i++) {
+        Gomoku g;
+        int n_moves = rnd_eng() % 60;
+        for (int k = 0; k < n_moves && !g.get_status().end; k++) {
+            auto moves = g.get_all_legal_moves();
+            g.move(moves[rnd_eng() % moves.size()]);
+        }
+        if (g.get_status().end) {
+            expect(g.legal_moves().size() == 0 && g.get_all_legal_moves().empty(), "none after the end");
+            continue;
+        }
+
+        // against a per-cell scan, in the same order
+        vector<M> expected;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                if (g.is_legal_move(M{ r, c })) expected.push_back(M{ r, c });
+            }
+        }
+        auto moves = g.legal_moves();
+        expect(moves.size() == int(expected.size()) && LegalMoves<Gomoku>::count(g) == moves.size(), "count");
+        int j = 0;
+        bool same = true;
+        for (M m : moves) {
+            same = same && j < int(expected.size()) && m == expected[j++] && moves.contains(m);
+        }
+        expect(same && j == int(expected.size()), "same moves");
+
+        // neighbourhood against the Chebyshev distance to the nearest stone
+        for (int d : { 1, 2, 3 }) {
+            Bits256 nb = g.neighbourhood(d);
+            bool ok = true;
+            for (int r = 0; r < BOARD_SIZE; r++) {
+                for (int c = 0; c < BOARD_SIZE; c++) {
+                    bool near = false;
+                    for (int dr = -d; dr <= d; dr++) {
+                        for (int dc = -d; dc <= d; dc++) {
+                            near = near || g.black.safe_get(r + dr, c + dc) || g.white.safe_get(r + dr, c + dc);
+                        }
+                    }
+                    bool in = g.is_legal_move(M{ r, c }) && near;
+                    ok = ok && nb.test(Gomoku::cell_index(M{ r, c })) == in;
+                }
+            }
+            expect(ok && nb.and_not(Gomoku::board_cells()).none(), "neighbourhood");
+        }
+    }
+}
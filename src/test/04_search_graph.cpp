@@ -0,0 +1,386 @@
+#include "test.h"
+#include <maestro/search/search_graph.h>
+#include <maestro/search/search_tree.h>
+#include <maestro/search/search_tree_compact.h>
+#include <maestro/game/game_gomoku.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_async.h>
+#include <maestro/search/transposition_table.h>
+#include <maestro/search/puct.h>
+#include <random>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+using namespace Maestro;
+
+TEST_CASE(search_graph_parallel) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.n_threads = 4;
+    MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+    search.simulate(2000);
+    search.simulate(2000);
+
+    int visits = 0;
+    for (auto& mv : search.get_moves()) {
+        visits += mv.visit_count;
+    }
+    // the first simulation evaluates the root
+    expect(visits == 3999, "every simulation should pass a root action");
+    expect(search.global_stat.sim_total == 4000, "sim total");
+    expect(search.get_value(g.get_color()) >= -1 && search.get_value(g.get_color()) <= 1, "value range");
+
+    auto m = search.pick_move(0);
+    search.move(m);
+    search.simulate(1000);
+    expect(search.get_game_snapshot().get_color() == Color::A, "color after move");
+}
+
+TEST_CASE(search_graph_async) {
+    auto eval = make_shared<AsyncEvaluator<Gomoku>>(make_shared<SimplisticGomokuEvaluator>(), 2);
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.n_threads = 2;
+    c.eval_queue_depth = 3;
+    MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+    search.simulate(3000);
+
+    int visits = 0;
+    for (auto& mv : search.get_moves()) {
+        visits += mv.visit_count;
+    }
+    auto& stat = search.global_stat;
+    expect(visits == 2999, "every simulation should pass a root action");
+    expect(stat.node_evaluated_total > 100, "leaves evaluated");
+    expect(stat.eval_max_in_flight >= 1 && stat.eval_max_in_flight <= 3, "queue depth respected");
+    expect(stat.eval_utilization() > 0, "utilization tracked");
+
+    auto m = search.pick_move(0);
+    search.move(m);
+    search.simulate(500);
+    expect(search.get_game_snapshot().get_color() == Color::A, "color after move");
+}
+
+namespace {
+    // black wins everywhere: +1 for black to move, -1 for white, so every
+    // simulation backs up exactly +1 for black; slow, so batches pile up
+    class BlackWinsEvaluator final : public IEvaluator<Gomoku> {
+        SimplisticGomokuEvaluator _evaluator;
+    public:
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            Evaluation<Gomoku> e = _evaluator.evaluate(game);
+            e.v = game.get_color() == Color::A ? 1.0f : -1.0f;
+            return e;
+        }
+        vector<Evaluation<Gomoku>> evaluate(const vector<Gomoku*>& games) override {
+            this_thread::sleep_for(chrono::microseconds(200));
+            return IEvaluator<Gomoku>::evaluate(games);
+        }
+    };
+
+    // counts the positions evaluated more than once
+    class RepeatCountingEvaluator final : public IEvaluator<Gomoku> {
+        SimplisticGomokuEvaluator _evaluator;
+        mutex _mutex;
+        unordered_set<uint64_t> _seen;
+    public:
+        int repeats = 0;
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            {
+                lock_guard<mutex> guard(_mutex);
+                if (!_seen.insert(game.get_zobrist()).second) repeats++;
+            }
+            return _evaluator.evaluate(game);
+        }
+    };
+}
+
+// Many move orders reach the same states, which several workers then try
+// to add to their batches while others apply their evaluations.
+// Workers that only reach leaves other workers are evaluating wait for
+// them instead of backing up placeholder values.
+TEST_CASE(search_graph_pending_leaves) {
+    auto eval = make_shared<AsyncEvaluator<Gomoku>>(make_shared<BlackWinsEvaluator>(), 2);
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });
+
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.n_threads = 4;
+    c.leaf_batch_count = 4;
+    c.eval_queue_depth = 2;
+    MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+    for (int i = 1; i <= 4; i++) {
+        search.simulate(500);
+        auto& stat = search.global_stat;
+        int visits = 0;
+        for (auto& mv : search.get_moves()) {
+            visits += mv.visit_count;
+        }
+        expect(stat.sim_total == 500 * i && visits == 500 * i - 1, "only simulations with a value are counted");
+        // up to the rounding of corrections weighted by visits over ns
+        expect(fabs(search.get_value(Color::A) - 1) < 1e-2, "no placeholder values left in the value");
+        // a stalled worker waits for a batch instead of spinning
+        expect(stat.visit_evaluating <= (stat.eval_batch_count + 1) * c.n_threads, "stalls bounded by batches");
+    }
+}
+
+TEST_CASE(search_graph_transposition_batches) {
+    Gomoku g;
+    for (auto m : { Move<Gomoku>{ 7, 7 }, Move<Gomoku>{ 7, 8 }, Move<Gomoku>{ 8, 7 }, Move<Gomoku>{ 8, 8 } }) {
+        g.move(m);
+    }
+    for (int round = 0; round < 5; round++) {
+        auto eval = make_shared<RepeatCountingEvaluator>();
+        MonteCarloGraphSearch<Gomoku>::Config c;
+        c.same_response = true;
+        c.n_threads = 4;
+        c.leaf_batch_count = 8;
+        MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+        search.simulate(5000);
+        expect(search.global_stat.sim_total == 5000, "sim total");
+        expect(eval->repeats == 0, "a state is evaluated once");
+    }
+}
+
+TEST_CASE(transposition_table) {
+    TranspositionTable<shared_ptr<int>> tt(16);
+    auto eq = [](int v) { return [v](const shared_ptr<int>& p) { return *p == v; }; };
+
+    // everything below hashes into the same bucket
+    uint64_t h = 0;
+    for (int i = 0; i < TranspositionTable<int>::BUCKET_SIZE; i++) {
+        tt.find_or_insert(h, eq(i), [i]() { return make_shared<int>(i); });
+    }
+    expect(tt.size() == TranspositionTable<int>::BUCKET_SIZE, "bucket filled");
+    shared_ptr<int> found;
+    expect(tt.find(h, eq(3), found) && *found == 3, "find after insert");
+    expect(!tt.find(h, eq(100), found), "verification rejects a hash match");
+
+    // refresh everything but value 0, which then is the oldest entry
+    tt.next_generation();
+    for (int i = 1; i < TranspositionTable<int>::BUCKET_SIZE; i++) {
+        tt.find(h, eq(i), found);
+    }
+    auto p = tt.find_or_insert(h, eq(100), []() { return make_shared<int>(100); });
+    expect(*p == 100, "inserted");
+    expect(!tt.find(h, eq(0), found), "oldest entry replaced");
+    expect(tt.replaced() == 1, "replace count");
+
+    tt.erase_if([](const shared_ptr<int>& p) { return *p % 2 == 0; });
+    expect(tt.size() == 3, "erase even values");
+
+    tt.clear();
+    expect(tt.size() == 0 && !tt.find(h, eq(1), found), "clear");
+
+    tt.find_or_insert(h, eq(1), []() { return make_shared<int>(1); });
+    tt.expire();
+    expect(tt.size() == 0 && !tt.find(h, eq(1), found), "expire");
+    tt.find_or_insert(h, eq(2), []() { return make_shared<int>(2); });
+    expect(tt.size() == 1 && tt.find(h, eq(2), found), "insert after expire");
+}
+
+TEST_CASE(search_graph_reuse) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.dirichlet_noise = true;
+    c.background_free = true;
+    MonteCarloGraphSearch<Gomoku> search(eval, Gomoku(), c);
+
+    for (int i = 0; i < 10; i++) {
+        search.simulate(300);
+        auto moves = search.get_moves();
+        expect(int(moves.size()) == BOARD_SIZE * BOARD_SIZE - i, "noise adds every legal move at the root");
+
+        auto m = search.pick_move(0);
+        int visit = 0;
+        for (auto& mv : moves) {
+            if (mv.move == m) visit = mv.visit_count;
+        }
+        search.move(m);
+
+        // the chosen subtree survives the move
+        int child_visits = 0;
+        for (auto& mv : search.get_moves()) {
+            child_visits += mv.visit_count;
+        }
+        expect(visit <= 2 || child_visits > 0, "subtree kept");
+        expect(visit <= 1 || search.global_stat.n_states > 1, "nodes kept");
+        auto& stat = search.global_stat;
+        expect(stat.gc_moves == i + 1 && stat.gc_kept == stat.n_states && stat.gc_dropped > 0, "gc stat");
+    }
+    search.print_stat();
+}
+
+TEST_CASE(puct_argmax) {
+    minstd_rand rnd_eng(7);
+    uniform_real_distribution<float> unit(0, 1);
+    for (int n = 1; n <= 225; n += 7) {
+        vector<EdgeLane> lanes(edge_lane_count(n));
+        for (int i = 0; i < n; i++) {
+            EdgeLane& lane = lanes[i >> 3];
+            lane.p[i & 7] = unit(rnd_eng);
+            lane.visit[i & 7] = rnd_eng() % 50;
+            lane.q[i & 7] = lane.visit[i & 7] > 0 ? unit(rnd_eng) * 2 - 1 : 0;
+            lane.vl[i & 7] = lane.visit[i & 7] > 0 ? rnd_eng() % 3 : 0;
+        }
+        pad_edge_lanes(lanes.data(), n);
+
+        float c = 2 * sqrtf(float(rnd_eng() % 1000));
+        int best = puct_argmax(lanes.data(), n, c, 1);
+        expect(best == puct_argmax_scalar(lanes.data(), n, c, 1), "vector and scalar argmax agree");
+
+        vector<float> scores(n);
+        puct_scores(lanes.data(), n, c, 1, scores.data());
+        for (int i = 0; i < n; i++) {
+            expect(scores[i] <= scores[best], "argmax is a maximum");
+        }
+    }
+
+    // ties go to the last edge
+    vector<EdgeLane> lanes(edge_lane_count(20));
+    pad_edge_lanes(lanes.data(), 20);
+    expect(puct_argmax(lanes.data(), 20, 1, 1) == 19, "last of equal scores");
+    expect(puct_argmax_scalar(lanes.data(), 20, 1, 1) == 19, "last of equal scores (scalar)");
+}
+
+TEST_CASE(search_budget) {
+    using M = Move<Gomoku>;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+
+    {
+        Gomoku g;
+        g.move(M{ 7, 7 });
+        MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+        SearchBudget budget;
+        budget.max_sims = 500;
+        budget.early_stop = false;
+        auto report = search.search(budget);
+        expect(report.sims == 500 && search.global_stat.sim_total == 500, "simulation budget");
+
+        budget.max_sims = INT_MAX;
+        budget.deadline = chrono::steady_clock::now() + chrono::milliseconds(30);
+        report = search.search(budget);
+        expect(report.seconds >= 0.03 && report.seconds < 0.2, "deadline");
+        expect(report.visit_entropy > 0 && report.visit_entropy <= 1, "entropy range");
+    }
+
+    // a single winning move soon can't be overtaken
+    Gomoku g;
+    for (auto m : { M{ 7, 3 }, M{ 7, 2 }, M{ 7, 4 }, M{ 0, 0 }, M{ 7, 5 }, M{ 0, 14 }, M{ 7, 6 }, M{ 14, 0 } }) {
+        g.move(m);
+    }
+    MonteCarloGraphSearch<Gomoku> search(eval, g, c);
+    SearchBudget budget;
+    budget.max_sims = 20000;
+    auto report = search.search(budget);
+    expect(report.early_stopped && report.sims < 20000, "early stop");
+    expect(search.pick_move(0) == M{ 7, 7 } && report.best_share > 0.5f, "winning move");
+}
+
+TEST_CASE(search_tree_compact) {
+    using M = Move<Gomoku>;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    // black to move, with four in a row on row 7
+    Gomoku g;
+    for (M m : { M{ 7, 7 }, M{ 0, 0 }, M{ 7, 8 }, M{ 0, 2 }, M{ 7, 9 }, M{ 0, 4 }, M{ 7, 10 }, M{ 14, 14 } }) {
+        g.move(m);
+    }
+    auto winning = [](M m) { return m == M{ 7, 6 } || m == M{ 7, 11 }; };
+
+    CompactMonteCarloTreeSearch<Gomoku>::Config c;
+    c.same_response = true;
+    CompactMonteCarloTreeSearch<Gomoku> search(eval, g, c);
+    expect(search.simulate(1000) == 1000, "simulations run");
+    int visits = 0;
+    for (auto& mv : search.get_moves()) {
+        visits += mv.visit_count;
+    }
+    expect(visits == 1000, "every simulation passes a root child");
+    expect(winning(search.pick_move(0)), "finds the win");
+    expect(search.get_value(Color::A) > 0.5f && search.get_value(Color::B) < -0.5f, "value");
+
+    // the heap tree agrees
+    MonteCarloTreeSearch<Gomoku> tree(&g, 2, eval.get());
+    tree.simulate(1000);
+    expect(winning(tree.pick_move(0)), "heap tree finds the win");
+
+    // move() keeps the chosen subtree, and only it
+    CompactMonteCarloTreeSearch<Gomoku> s(eval, Gomoku(), c);
+    for (int i = 0; i < 5; i++) {
+        s.simulate(500);
+        auto moves = s.get_moves();
+        expect(int(moves.size()) == BOARD_SIZE * BOARD_SIZE - i, "noise adds every legal move at the root");
+        M m = s.pick_move(0);
+        int visit = 0;
+        for (auto& mv : moves) {
+            if (mv.move == m) visit = mv.visit_count;
+        }
+        size_t n_before = s.node_count();
+        s.move(m);
+        int child_visits = 0;
+        for (auto& mv : s.get_moves()) {
+            child_visits += mv.visit_count;
+        }
+        expect(child_visits == visit - 1, "subtree kept");
+        expect(s.node_count() < n_before, "other subtrees dropped");
+    }
+    bool thrown = false;
+    try {
+        s.move(M{ 7, 7 });
+        s.move(M{ 7, 7 });
+    } catch (invalid_argument&) {
+        thrown = true;
+    }
+    expect(thrown, "illegal move");
+    s.print_stat();
+}
+
+TEST_CASE(search_tree_batch) {
+    using M = Move<Gomoku>;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    Gomoku g;
+    for (M m : { M{ 7, 7 }, M{ 0, 0 }, M{ 7, 8 }, M{ 0, 2 }, M{ 7, 9 }, M{ 0, 4 }, M{ 7, 10 }, M{ 14, 14 } }) {
+        g.move(m);
+    }
+    auto winning = [](M m) { return m == M{ 7, 6 } || m == M{ 7, 11 }; };
+    auto visits = [](IMonteCarloSearch<Gomoku>& s) {
+        int n = 0;
+        for (auto& mv : s.get_moves()) {
+            n += mv.visit_count;
+        }
+        return n;
+    };
+
+    CompactMonteCarloTreeSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.leaf_batch_count = 16;
+    CompactMonteCarloTreeSearch<Gomoku> compact(eval, g, c);
+    expect(compact.simulate(1000) == 1000 && visits(compact) == 1000, "compact: simulations run");
+    expect(winning(compact.pick_move(0)), "compact: finds the win");
+    auto& stat = compact.stat;
+    expect(stat.evaluated + stat.game_end == 1001, "compact: one evaluation or game end per simulation");
+    expect(stat.batches < stat.evaluated / 2, "compact: leaves batched");
+
+    // a fresh position, where batches are not cut short by game ends
+    CompactMonteCarloTreeSearch<Gomoku> opening(eval, Gomoku(), c);
+    opening.simulate(2000);
+    expect(visits(opening) == 2000, "opening: virtual losses reverted");
+    expect(opening.stat.evaluated > 8 * opening.stat.batches, "opening: large batches");
+
+    MonteCarloTreeSearch<Gomoku> tree(&g, 2, eval.get(), nullptr, 16);
+    expect(tree.simulate(1000) == 1000 && visits(tree) == 1000, "heap: simulations run");
+    expect(winning(tree.pick_move(0)), "heap: finds the win");
+}
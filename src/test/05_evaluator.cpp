@@ -0,0 +1,342 @@
+#include "test.h"
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <maestro/evaluator/inference_server.h>
+#include <maestro/evaluator/eval_gomoku_nn.h>
+#include <maestro/evaluator/eval_cache.h>
+#include <maestro/evaluator/eval_gomoku_symmetric.h>
+#include <maestro/search/search_graph.h>
+#include <thread>
+#include <random>
+#include <cmath>
+
+using namespace Maestro;
+
+namespace {
+    // depends on the orientation: priors grow with the cell index, the
+    // value with the stones in the upper half
+    class OrientedEvaluator final : public IEvaluator<Gomoku> {
+    public:
+        int n_evaluated = 0;
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            n_evaluated++;
+            Evaluation<Gomoku> e;
+            float sum = 0;
+            for (auto m : game.get_all_legal_moves()) {
+                float p = float(m.row * BOARD_SIZE + m.col + 1);
+                e.p.push_back(MovePrior<Gomoku>{ m, p });
+                sum += p;
+            }
+            for (auto& mp : e.p) {
+                mp.p /= sum;
+            }
+            for (int r = 0; r < BOARD_SIZE / 2; r++) {
+                for (int c = 0; c < BOARD_SIZE; c++) {
+                    e.v += game.black.get(r, c) ? 0.1f : 0;
+                }
+            }
+            return e;
+        }
+    };
+}
+
+TEST_CASE(simplistic_priors) {
+    using M = Move<Gomoku>;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    auto e0 = eval->evaluate(Gomoku());
+    expect(e0.p.size() == 1 && e0.p[0].move == M{ 7, 7 } && e0.p[0].p == 1, "empty board");
+
+    minstd_rand rnd_eng(97);
+    for (int i = 0; i < 100; i++) {
+        Gomoku g;
+        int n_moves = 1 + rnd_eng() % 80;
+        for (int k = 0; k < n_moves && !g.get_status().end; k++) {
+            auto moves = g.get_all_legal_moves();
+            g.move(moves[rnd_eng() % moves.size()]);
+        }
+
+        // empty cells next to a stone, in row-major order
+        vector<M> expected;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                bool near = false;
+                for (int dr = -1; dr <= 1; dr++) {
+                    for (int dc = -1; dc <= 1; dc++) {
+                        near = near || g.black.safe_get(r + dr, c + dc) || g.white.safe_get(r + dr, c + dc);
+                    }
+                }
+                if (near && g.is_legal_move_unchecked(M{ r, c })) expected.push_back(M{ r, c });
+            }
+        }
+
+        auto e = eval->evaluate(g);
+        bool same = e.p.size() == expected.size();
+        float sum = 0;
+        float n = float(expected.size());
+        for (int j = 0; same && j < int(e.p.size()); j++) {
+            same = e.p[j].move == expected[j] && e.p[j].p > 0.998f / n && e.p[j].p < 1.002f / n;
+            sum += e.p[j].p;
+        }
+        expect(same, "moves next to a stone, nearly uniform");
+        expect(fabs(sum - 1) < 1e-5f, "normalized");
+        auto again = eval->evaluate(g);
+        expect(again.p[0].p == e.p[0].p && again.p.back().p == e.p.back().p, "deterministic");
+    }
+}
+
+TEST_CASE(pattern_evaluator) {
+    using M = Move<Gomoku>;
+    using T = PatternGomokuEvaluator::Threat;
+    // x own, o blocked, the centre is the fifth cell
+    auto threat = [](const char* w) {
+        uint32_t own = 0, blocked = 0;
+        for (int i = 0; i < 9; i++) {
+            own |= uint32_t(w[i] == 'x') << i;
+            blocked |= uint32_t(w[i] == 'o') << i;
+        }
+        return PatternGomokuEvaluator::threat(own, blocked);
+    };
+    expect(threat("xxxx.o...") == T::FIVE, "five");
+    expect(threat("xxxx.x...") != T::FIVE, "overline");
+    expect(threat(".xxx.....") == T::OPEN_FOUR, "open four");
+    expect(threat("xxx...xxx") == T::OPEN_FOUR, "two fours in a line");
+    expect(threat("oxxx.....") == T::FOUR, "four");
+    expect(threat("..xx.....") == T::OPEN_THREE, "open three");
+    expect(threat("...x.x...") == T::OPEN_THREE, "split three");
+    expect(threat("oxx......") == T::THREE, "three");
+    expect(threat("...x.....") == T::OPEN_TWO, "open two");
+    expect(threat("ooox.o...") == T::NONE, "no room for five");
+    expect(threat("ooooooooo") == T::NONE && threat(".........") == T::NONE, "nothing");
+
+    auto eval = make_shared<PatternGomokuEvaluator>();
+    auto e0 = eval->evaluate(Gomoku());
+    expect(e0.p.size() == 1 && e0.p[0].move == M{ 7, 7 }, "empty board");
+
+    // black has an open four, white stones are scattered
+    Gomoku g;
+    for (int i = 0; i < 4; i++) {
+        g.move(M{ 7, 3 + i });
+        if (i < 3) g.move(M{ 0, 2 * i });
+    }
+    auto e = eval->evaluate(g);
+    expect(e.v == -1 && e.p.size() == 2, "white cannot block both ends");
+    g.move(M{ 7, 2 });
+    e = eval->evaluate(g);
+    expect(e.v == 1 && e.p.size() == 1 && e.p[0].move == M{ 7, 7 } && e.p[0].p == 1, "black wins");
+    g.move(M{ 7, 7 });
+    expect(g.get_status().end && g.get_status().winner == Color::A, "five");
+
+    // white to move, black has a four on the edge and a three
+    Gomoku h;
+    const M black[] = { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 }, { 9, 9 }, { 10, 10 }, { 11, 11 } };
+    const M white[] = { { 5, 0 }, { 5, 4 }, { 3, 8 }, { 2, 12 }, { 12, 3 }, { 14, 8 } };
+    for (int i = 0; i < 7; i++) {
+        h.move(black[i]);
+        if (i < 6) h.move(white[i]);
+    }
+    h.move(M{ 13, 0 });
+    h.move(M{ 4, 14 });
+    e = eval->evaluate(h);
+    expect(e.p.size() == 1 && e.p[0].move == M{ 0, 4 } && e.v > -1 && e.v < 0, "forced block");
+    h.move(M{ 0, 4 });
+    e = eval->evaluate(h);
+    float sum = 0, to_open_four = 0;
+    for (auto& mp : e.p) {
+        sum += mp.p;
+        if (mp.move == M{ 8, 8 } || mp.move == M{ 12, 12 }) to_open_four += mp.p;
+    }
+    expect(fabs(sum - 1) < 1e-5f, "normalized");
+    expect(to_open_four > 0.5f && e.v == 0.9f, "open three made four");
+}
+
+TEST_CASE(inference_server) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    InferenceServer<Gomoku>::Config c;
+    c.max_batch_size = 64;
+    c.max_latency = chrono::milliseconds(20);
+    auto server = make_shared<InferenceServer<Gomoku>>(eval, c);
+
+    // several clients, each waiting on small requests of its own games
+    const int n_clients = 8, n_requests = 20;
+    vector<thread> clients;
+    vector<int> mismatches(n_clients);
+    for (int i = 0; i < n_clients; i++) {
+        clients.emplace_back([&, i]() {
+            Gomoku g;
+            g.move(Move<Gomoku>{ i, i });
+            for (int k = 0; k < n_requests; k++) {
+                vector<Gomoku> games;
+                for (int j = 0; j < 3; j++) {
+                    Gomoku h = g;
+                    h.move(Move<Gomoku>{ 14 - j, k % BOARD_SIZE });
+                    games.push_back(h);
+                }
+                auto evals = server->evaluate_async(games).get();
+                for (int j = 0; j < 3; j++) {
+                    auto direct = eval->evaluate(games[j]);
+                    if (evals[j].v != direct.v || evals[j].p.size() != direct.p.size()) {
+                        mismatches[i]++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : clients) {
+        t.join();
+    }
+
+    for (int m : mismatches) {
+        expect(m == 0, "results routed back to their request");
+    }
+    auto stat = server->stat();
+    expect(stat.n_requests == n_clients * n_requests, "request count");
+    expect(stat.n_positions == n_clients * n_requests * 3, "position count");
+    expect(stat.mean_batch_size() > 3, "requests of different clients merged");
+    expect(stat.n_positions <= stat.n_batches * 64, "batch size bound");
+
+    // a lone request is sent once its deadline passes
+    auto start = chrono::steady_clock::now();
+    server->evaluate(Gomoku());
+    expect(chrono::steady_clock::now() - start >= chrono::milliseconds(20), "waited for the batch to fill");
+}
+
+TEST_CASE(nn_encode) {
+    Gomoku g;
+    g.move(Move<Gomoku>{ 7, 7 });   // black
+    g.move(Move<Gomoku>{ 0, 14 });  // white
+    g.move(Move<Gomoku>{ 14, 0 });  // black, white to move
+
+    const int n = NNGomokuEvaluator::PLANE_SIZE;
+    vector<float> planes(NNGomokuEvaluator::PLANES * n, -1);
+    NNGomokuEvaluator::encode(g, planes.data());
+
+    auto at = [&](int plane, int r, int c) { return planes[plane * n + r * BOARD_SIZE + c]; };
+    expect(at(0, 0, 14) == 1, "own stone");
+    expect(at(1, 7, 7) == 1 && at(1, 14, 0) == 1, "opponent stones");
+    expect(at(2, 14, 0) == 1, "last move");
+    float sum = 0;
+    for (float x : planes) sum += x;
+    expect(sum == 4, "nothing else set, white to move");
+
+    g.move(Move<Gomoku>{ 3, 3 });
+    NNGomokuEvaluator::encode(g, planes.data());
+    expect(at(0, 7, 7) == 1 && at(1, 3, 3) == 1 && at(3, 5, 5) == 1, "black to move");
+}
+
+TEST_CASE(eval_cache) {
+    using M = Move<Gomoku>;
+    using S = Symmetry<Gomoku>;
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    Gomoku g;
+    g.move(M{ 3, 4 });
+    g.move(M{ 7, 8 });
+    g.move(M{ 10, 1 });
+    Evaluation<Gomoku> e = eval->evaluate(g);
+    e.v = 0.25f;
+
+    EvaluationCache<Gomoku> cache(4, 1);
+    cache.insert(g, e);
+    for (int sym = 0; sym < S::COUNT; sym++) {
+        Evaluation<Gomoku> out;
+        expect(cache.find(S::apply(g, sym), out), "every orientation hits");
+        bool same = out.v == e.v && out.p.size() == e.p.size();
+        for (int i = 0; same && i < int(e.p.size()); i++) {
+            same = out.p[i].move == S::apply(e.p[i].move, sym) && out.p[i].p == e.p[i].p;
+        }
+        expect(same, "priors in the orientation of the query");
+    }
+
+    // least recently used entries go first
+    vector<Gomoku> others;
+    for (int i = 0; i < 4; i++) {
+        Gomoku h = g;
+        h.move(M{ 14, i });
+        others.push_back(h);
+    }
+    Evaluation<Gomoku> out;
+    for (int i = 0; i < 3; i++) {
+        cache.insert(others[i], e);
+    }
+    expect(cache.find(g, out), "g used last");
+    cache.insert(others[3], e);
+    expect(cache.size() == 4, "bounded");
+    expect(cache.find(g, out) && !cache.find(others[0], out), "oldest evicted");
+    expect(cache.stat().hits == 10 && cache.stat().lookups == 11, "stat");
+
+    // the same stones played in another order differ in their last move
+    Gomoku reordered;
+    reordered.move(M{ 10, 1 });
+    reordered.move(M{ 7, 8 });
+    reordered.move(M{ 3, 4 });
+    expect(reordered == g && !cache.find(reordered, out), "last move is part of the key");
+
+    // a search on a mirrored position reuses the evaluations of the first one
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    c.eval_cache = make_shared<EvaluationCache<Gomoku>>(1 << 16);
+    c.n_threads = 2;
+    MonteCarloGraphSearch<Gomoku> s1(eval, g, c);
+    s1.simulate(1000);
+    MonteCarloGraphSearch<Gomoku> s2(eval, S::apply(g, 6), c);
+    s2.simulate(1000);
+    s2.print_stat();
+    auto& stat = s2.global_stat;
+    // the root hits, every other position is either a hit or sent to the evaluator
+    expect(stat.eval_cache_lookups == stat.eval_cache_hits + stat.node_evaluated_total, "lookups");
+    expect(stat.eval_cache_hit_rate() > 0.5, "hits across searches");
+}
+
+TEST_CASE(eval_symmetric) {
+    using M = Move<Gomoku>;
+    using S = Symmetry<Gomoku>;
+    auto inner = make_shared<OrientedEvaluator>();
+    Gomoku g;
+    g.move(M{ 3, 4 });
+    g.move(M{ 7, 8 });
+    g.move(M{ 1, 1 });
+
+    // prior of m in the evaluation of t under s
+    auto prior = [&](const Gomoku& t, int s, M m) {
+        M ms = S::apply(m, s);
+        for (auto& mp : inner->evaluate(S::apply(t, s)).p) {
+            if (mp.move == ms) return mp.p;
+        }
+        return 0.0f;
+    };
+
+    SymmetricGomokuEvaluator one(inner, 1), all(inner, 8);
+    for (int sym : { 0, 5 }) {
+        Gomoku t = S::apply(g, sym);
+
+        // one symmetry: the evaluation of some orientation, mapped back
+        inner->n_evaluated = 0;
+        Evaluation<Gomoku> e1 = one.evaluate(t);
+        expect(inner->n_evaluated == 1, "no extra evaluations");
+        bool found = false;
+        for (int s = 0; s < S::COUNT && !found; s++) {
+            found = e1.v == inner->evaluate(S::apply(t, s)).v;
+            for (auto& mp : e1.p) {
+                found = found && mp.p == prior(t, s, mp.move);
+            }
+        }
+        expect(found, "one orientation");
+
+        // all eight: the average over the orbit
+        Evaluation<Gomoku> e8 = all.evaluate(t);
+        float v = 0;
+        for (int s = 0; s < S::COUNT; s++) {
+            v += inner->evaluate(S::apply(t, s)).v / S::COUNT;
+        }
+        expect(fabs(e8.v - v) < 1e-5f, "averaged value");
+        expect(e8.p.size() == t.get_all_legal_moves().size(), "one prior per move");
+        bool same = true;
+        for (auto& mp : e8.p) {
+            float p = 0;
+            for (int s = 0; s < S::COUNT; s++) {
+                p += prior(t, s, mp.move) / S::COUNT;
+            }
+            same = same && fabs(mp.p - p) < 1e-6f;
+        }
+        expect(same, "averaged priors");
+    }
+}
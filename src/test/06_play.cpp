@@ -0,0 +1,347 @@
+#include "test.h"
+#include <maestro/play/match.h>
+#include <maestro/play/self_play.h>
+#include <maestro/search/search_graph.h>
+#include <maestro/evaluator/eval_gomoku_simplistic.h>
+#include <maestro/evaluator/eval_gomoku_pattern.h>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace Maestro;
+
+namespace {
+    // plays a random legal move, drawn from its own generator
+    class RandomGomokuPlayer final : public IPlayer<Gomoku> {
+        minstd_rand _rnd_eng;
+    public:
+        explicit RandomGomokuPlayer(uint32_t seed) : _rnd_eng(seed) {}
+        Move<Gomoku> get_move(const Gomoku& game) override {
+            auto moves = game.get_all_legal_moves();
+            return moves[_rnd_eng() % moves.size()];
+        }
+        void move(Move<Gomoku> m) override {}
+    };
+
+    // plays the move of the highest prior
+    class GreedyGomokuPlayer final : public IPlayer<Gomoku> {
+        PatternGomokuEvaluator _evaluator;
+    public:
+        Move<Gomoku> get_move(const Gomoku& game) override {
+            auto eval = _evaluator.evaluate(game);
+            return max_element(eval.p.begin(), eval.p.end(), [](auto& a, auto& b) { return a.p < b.p; })->move;
+        }
+        void move(Move<Gomoku> m) override {}
+    };
+
+    // plays randomly, but holds its first move until released
+    class HeldPlayer final : public IPlayer<Gomoku> {
+        RandomGomokuPlayer _player;
+        atomic<bool>& _entered;
+        atomic<bool>& _released;
+    public:
+        HeldPlayer(uint32_t seed, atomic<bool>& entered, atomic<bool>& released)
+            : _player(seed), _entered(entered), _released(released) {}
+        Move<Gomoku> get_move(const Gomoku& game) override {
+            _entered = true;
+            while (!_released) this_thread::yield();
+            return _player.get_move(game);
+        }
+        void move(Move<Gomoku> m) override {}
+    };
+
+    class FailingPlayer final : public IPlayer<Gomoku> {
+    public:
+        Move<Gomoku> get_move(const Gomoku& game) override {
+            throw runtime_error("player failed");
+        }
+        void move(Move<Gomoku> m) override {}
+    };
+
+    class FailingEvaluator final : public IEvaluator<Gomoku> {
+    public:
+        Evaluation<Gomoku> evaluate(const Gomoku& game) override {
+            throw runtime_error("evaluator failed");
+        }
+    };
+}
+
+TEST_CASE(player_ponder) {
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    auto s1 = make_shared<MonteCarloGraphSearch<Gomoku>>(eval, Gomoku(), c);
+    auto s2 = make_shared<MonteCarloGraphSearch<Gomoku>>(eval, Gomoku(), c);
+    MonteCarloAIPlayer<Gomoku> p1(s1, 200, true, 100000), p2(s2, 200);
+
+    Gomoku g;
+    for (int i = 0; i < 4; i++) {
+        auto m1 = p1.get_move(g);
+        g.move(m1);
+        p1.move(m1);
+        p2.move(m1);
+
+        // p1 searches the replies while p2 thinks
+        this_thread::sleep_for(chrono::milliseconds(20));
+        auto m2 = p2.get_move(g);
+        g.move(m2);
+        p1.move(m2);
+        p2.move(m2);
+
+        int visits = 0;
+        for (auto& mv : s1->get_moves()) {
+            visits += mv.visit_count;
+        }
+        expect(visits > 0, "the pondered subtree of the reply is kept");
+        expect(s1->get_game_snapshot() == g, "in sync");
+    }
+    expect(p1.ponder_simulations() > 0, "pondered");
+    expect(p1.simulations() == p1.ponder_simulations() + 4 * 200, "ponder and move simulations");
+    expect(p2.ponder_simulations() == 0 && p2.simulations() == 4 * 200, "no pondering");
+
+    // stopping takes effect within a simulation, not at the end of the budget
+    auto m = p1.get_move(g);
+    g.move(m);
+    p1.move(m);
+    this_thread::sleep_for(chrono::milliseconds(5));
+    auto start = chrono::steady_clock::now();
+    p1.move(g.get_all_legal_moves()[0]);
+    expect(chrono::steady_clock::now() - start < chrono::milliseconds(500), "stops promptly");
+}
+
+TEST_CASE(match_parallel) {
+    int created = 0;
+    auto p1_creator = [&created]() { ++created; return make_shared<GreedyGomokuPlayer>(); };
+    auto p2_creator = [&created]() { return make_shared<RandomGomokuPlayer>(++created); };
+
+    Match<Gomoku>::Config c;
+    c.n_threads = 4;
+    c.quiet = true;
+    Match<Gomoku> match(31, p1_creator, p2_creator, c);
+    expect(match.step(), "one round on the calling thread");
+    match.step_to_end();
+    MatchStat s = match.stat();
+    expect(s.total == 32 && s.current == 33, "rounds rounded up to even and all played");
+    expect(s.p1_win == 32 && s.p2_win == 0 && s.draw == 0, "wins counted for the player, whichever side it played");
+    expect(created == 64, "fresh players every round");
+    expect(!match.step(), "nothing left");
+
+    // a failing round stops the match, and its error reaches the caller
+    int started = 0;
+    Match<Gomoku> failing(32, [&started]() { ++started; return make_shared<GreedyGomokuPlayer>(); },
+        []() { return make_shared<FailingPlayer>(); }, c);
+    bool thrown = false;
+    try {
+        failing.step_to_end();
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    expect(thrown, "round error rethrown");
+    expect(started <= c.n_threads && failing.stat().current == 1, "no rounds started after a failure");
+    expect(!failing.step(), "stopped");
+}
+
+TEST_CASE(match_sprt) {
+    EloEstimate even = EloEstimate::from(50, 50, 20);
+    expect(fabs(even.elo) < 1e-9 && even.lower < -30 && even.upper > 30, "even");
+    EloEstimate ahead = EloEstimate::from(75, 25, 0);
+    expect(ahead.elo > 150 && ahead.elo < 220 && ahead.lower > 50 && ahead.upper > ahead.elo, "ahead");
+    expect(fabs(elo_to_score(score_to_elo(0.7)) - 0.7) < 1e-9, "score and elo");
+
+    Sprt::Config sc;
+    sc.elo0 = 0;
+    sc.elo1 = 100;
+    auto sprt = make_shared<Sprt>(sc);
+    expect(sprt->test(3, 2, 0) == Sprt::Result::Continue, "too early to tell");
+    expect(sprt->test(200, 200, 0) == Sprt::Result::H0 && sprt->test(300, 100, 0) == Sprt::Result::H1, "decided");
+
+    // the stronger player is told apart long before the rounds run out,
+    // whichever side it is
+    for (bool greedy_first : { true, false }) {
+        using Creator = function<shared_ptr<IPlayer<Gomoku>>()>;
+        Creator greedy = []() { return make_shared<GreedyGomokuPlayer>(); };
+        int seed = 0;
+        Creator random = [&seed]() { return make_shared<RandomGomokuPlayer>(++seed); };
+        FILE* json = tmpfile();
+        Match<Gomoku>::Config c;
+        c.n_threads = 2;
+        c.quiet = true;
+        c.sprt = sprt;
+        c.json = json;
+        Match<Gomoku> match(200, greedy_first ? greedy : random, greedy_first ? random : greedy, c);
+        match.step_to_end();
+        MatchStat s = match.stat();
+        expect(match.decision() == (greedy_first ? Sprt::Result::H1 : Sprt::Result::H0), "decision");
+        expect(s.current - 1 < 40, "stopped early");
+
+        // a line per round and one at the end
+        rewind(json);
+        char line[512];
+        int n_lines = 0;
+        string last;
+        while (fgets(line, sizeof(line), json)) {
+            n_lines++;
+            last = line;
+        }
+        fclose(json);
+        expect(n_lines == s.current, "streamed");
+        expect(last.find("\"event\":\"end\"") != string::npos && last.find(greedy_first ? "\"H1\"" : "\"H0\"") != string::npos, "end line");
+    }
+
+    // a round still running when the test decides is counted, but does not
+    // undo the decision
+    Sprt::Config lc;
+    lc.elo0 = 0;
+    lc.elo1 = 100;
+    auto latch = make_shared<Sprt>(lc);
+    atomic<bool> entered{ false }, released{ false };
+    int created = 0;
+    Match<Gomoku>::Config c;
+    c.quiet = true;
+    c.sprt = latch;
+    Match<Gomoku> match(100, [&]() -> shared_ptr<IPlayer<Gomoku>> {
+        if (++created == 1) return make_shared<HeldPlayer>(created, entered, released);
+        return make_shared<GreedyGomokuPlayer>();
+    }, [&]() -> shared_ptr<IPlayer<Gomoku>> {
+        if (created == 1) return make_shared<GreedyGomokuPlayer>();
+        return make_shared<RandomGomokuPlayer>(created);
+    }, c);
+    thread late([&match]() { match.step(); });
+    while (!entered) this_thread::yield();
+    while (match.step()) {}
+    expect(match.decision() == Sprt::Result::H1, "decided while a round runs");
+    released = true;
+    late.join();
+    MatchStat s = match.stat();
+    expect(s.p1_win == 5 && s.p2_win == 1 && s.draw == 0, "late round counted");
+    expect(latch->test(s.p1_win, s.p2_win, s.draw) == Sprt::Result::Continue, "late round alone would undo it");
+    expect(match.decision() == Sprt::Result::H1, "decision latched");
+}
+
+TEST_CASE(self_play) {
+    SelfPlay::Config c;
+    c.n_threads = 2;
+    c.n_sim = 50;
+    c.sample_plies = 4;
+    c.seed = 7;
+    string prefix = "self_play_test";
+    SelfPlay self_play(make_shared<PatternGomokuEvaluator>(), prefix, c);
+    for (int t = 0; t < 2; t++) {
+        remove(self_play.shard_path(t).c_str());
+    }
+    SelfPlay::Stat stat = self_play.play(4);
+    expect(stat.games == 4 && stat.black_win + stat.white_win + stat.draw == 4, "games");
+    expect(stat.positions_per_sec() > 0, "throughput");
+
+    int64_t n = 0, n_before = 0;
+    vector<uint64_t> openings;
+    for (int t = 0; t < 2; t++) {
+        TrainingDataReader reader(self_play.shard_path(t), 16);
+        GomokuRecord r;
+        int ply = 0;
+        while (reader.next(r)) {
+            n++;
+            Bits256 black(r.black[0], r.black[1], r.black[2], r.black[3]);
+            Bits256 white(r.white[0], r.white[1], r.white[2], r.white[3]);
+            if (black.none()) ply = 0;
+            expect(black.count() + white.count() == ply, "stones of the ply");
+            expect(bool(r.black_to_move) == (ply % 2 == 0), "side to move");
+            int sum = 0;
+            for (uint16_t p : r.policy) sum += p;
+            expect(abs(sum - 65535) < 225, "policy");
+            expect(r.outcome >= -1 && r.outcome <= 1, "outcome");
+            if (ply == 4) openings.push_back(r.black[1] * 3 + r.white[1]);
+            ply++;
+        }
+        // either thread may have played every game, leaving the other shard empty;
+        // the last position of a game is won by the player to move
+        if (reader.size() > 0) expect(r.outcome == 1, "winner moves last");
+        expect(int64_t(reader.size()) == n - n_before, "size");
+        n_before = n;
+    }
+    expect(n == stat.positions, "every position recorded");
+    sort(openings.begin(), openings.end());
+    expect(unique(openings.begin(), openings.end()) - openings.begin() > 1, "openings differ");
+
+    // appending keeps the records before, in whichever shard the game went to
+    auto records = [&self_play]() {
+        size_t total = 0;
+        for (int t = 0; t < 2; t++) {
+            total += TrainingDataReader(self_play.shard_path(t)).size();
+        }
+        return total;
+    };
+    size_t before = records();
+    SelfPlay::Stat more = self_play.play(1);
+    expect(records() == before + more.positions, "appended");
+
+    // a record torn by a writer that died is cut off before appending
+    string shard = self_play.shard_path(0);
+    size_t whole = TrainingDataReader(shard).size();
+    FILE* f = fopen(shard.c_str(), "ab");
+    GomokuRecord torn{};
+    fwrite(&torn, sizeof(torn) / 2, 1, f);
+    fclose(f);
+    {
+        TrainingDataWriter writer(shard);
+        writer.write(&torn, 1);
+    }
+    expect(TrainingDataReader(shard).size() == whole + 1, "torn record cut off");
+    for (int t = 0; t < 2; t++) {
+        remove(self_play.shard_path(t).c_str());
+    }
+
+    // an error in a worker is rethrown by play() once all are joined
+    SelfPlay failing(make_shared<FailingEvaluator>(), prefix, c);
+    bool thrown = false;
+    try {
+        failing.play(4);
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    expect(thrown, "worker error rethrown");
+    for (int t = 0; t < 2; t++) {
+        remove(failing.shard_path(t).c_str());
+    }
+}
+
+TEST_CASE(time_manager) {
+    TimeManager tm;
+    double nominal = tm.nominal(60, 1);
+    expect(nominal > 0 && nominal < 60 * tm.config().max_clock_share, "nominal");
+    expect(tm.nominal(0.01, 0) == 0, "nothing left to spend");
+
+    SearchReport forced, settled, critical;
+    forced.best_share = 0.95f;
+    settled.best_share = 0.6f;
+    settled.visit_entropy = 0.3f;
+    critical.best_share = 0.2f;
+    critical.visit_entropy = 0.8f;
+    critical.value_stddev = 0.2f;
+    expect(tm.move_time(nominal, forced) <= tm.first_search(nominal), "forced moves stop");
+    expect(tm.move_time(nominal, settled) < tm.move_time(nominal, critical), "critical positions get more");
+    expect(tm.move_time(nominal, critical) > nominal, "beyond nominal");
+
+    // a player on a clock stays within it
+    auto eval = make_shared<SimplisticGomokuEvaluator>();
+    MonteCarloGraphSearch<Gomoku>::Config c;
+    c.same_response = true;
+    auto search = make_shared<MonteCarloGraphSearch<Gomoku>>(eval, Gomoku(), c);
+    MonteCarloAIPlayer<Gomoku> player(search, 0);
+    player.set_clock(0.5, 0);
+    Gomoku g;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < 5; i++) {
+        auto m = player.get_move(g);
+        g.move(m);
+        player.move(m);
+    }
+    double used = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    expect(player.clock() > 0 && used < 0.5, "within the clock");
+    expect(player.simulations() > 0, "searched");
+}
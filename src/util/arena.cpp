@@ -0,0 +1 @@
+#include <maestro/util/arena.h>
\ No newline at end of file
@@ -0,0 +1 @@
+#include <maestro/util/bitboard.h>
\ No newline at end of file